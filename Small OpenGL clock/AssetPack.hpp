@@ -0,0 +1,505 @@
+#include "Theme.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#  ifndef WIN32_LEAN_AND_MEAN
+#    define WIN32_LEAN_AND_MEAN
+#  endif
+#  ifndef NOMINMAX
+#    define NOMINMAX
+#  endif
+#  include <windows.h>
+#else
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+#pragma once
+
+#ifndef ASSET_PACK_HPP
+#  define ASSET_PACK_HPP
+
+// CRC-32 as used by zlib and PNG
+constexpr std::array<std::uint32_t, 256> make_crc32_table() noexcept
+{
+    std::array<std::uint32_t, 256> table{};
+    for (std::uint32_t i{ 0 }; i < 256; i++)
+    {
+        std::uint32_t crc{ i };
+        for (int bit{ 0 }; bit < 8; bit++)
+            crc = (crc & 1) ? (crc >> 1) ^ 0xedb88320u : crc >> 1;
+        table[i] = crc;
+    }
+
+    return table;
+}
+
+constexpr std::array<std::uint32_t, 256> crc32_table{ make_crc32_table() };
+
+std::uint32_t crc32(const void* data, std::size_t size) noexcept
+{
+    const auto* bytes{ static_cast<const std::uint8_t*>(data) };
+    std::uint32_t crc{ 0xffffffffu };
+    for (std::size_t i{ 0 }; i < size; i++)
+        crc = crc32_table[(crc ^ bytes[i]) & 0xff] ^ (crc >> 8);
+
+    return crc ^ 0xffffffffu;
+}
+
+// Layout of an asset pack file: the header, a table of entries sorted by
+// name, then the contents of every entry, each followed by a NUL and padded
+// to 8 bytes. All integers are little-endian, as on every target we build.
+struct AssetPackHeader
+{
+    char magic[8]{ 'C', 'L', 'K', 'P', 'A', 'C', 'K', '\0' };
+    std::uint32_t version{};
+    std::uint32_t entry_count{};
+    std::uint64_t file_size{};
+    std::uint32_t table_crc32{};
+    std::uint32_t reserved{};
+};
+
+struct AssetPackEntry
+{
+    char name[48]{};
+    std::uint64_t offset{};
+    std::uint32_t size{};
+    std::uint32_t crc32{};
+};
+
+static_assert(sizeof(AssetPackHeader) == 32);
+static_assert(sizeof(AssetPackEntry) == 64);
+
+constexpr std::uint32_t asset_pack_version{ 1 };
+
+// The themes' colors as stored in the "palette" entry, one record per theme
+struct PaletteRecord
+{
+    char name[16]{};
+    float clear_color[3]{};
+    float circle_color[3]{};
+    float hand_colors[3][3]{};
+};
+
+// A read-only memory mapping of an asset pack. Every entry is checked
+// against its checksum once when the pack is opened; after that, looking an
+// entry up hands out a view straight into the mapping, without a copy or an
+// allocation.
+class AssetPack
+{
+    const char* m_data{};
+    std::size_t m_size{};
+
+    void unmap() noexcept;
+    bool validate(const std::string&) const noexcept;
+
+public:
+    AssetPack() noexcept = default;
+    ~AssetPack() noexcept;
+
+    AssetPack(const AssetPack&) = delete;
+    AssetPack& operator=(const AssetPack&) = delete;
+
+    bool open(const std::string&) noexcept;
+    bool is_open() const noexcept;
+
+    bool find(std::string_view, std::string_view&) const noexcept;
+};
+
+AssetPack::~AssetPack() noexcept
+{
+    this->unmap();
+}
+
+// Maps the pack at `path`. A missing pack is not an error, since the loose
+// files are used then; one that fails validation is reported and ignored.
+bool AssetPack::open(const std::string& path) noexcept
+{
+    this->unmap();
+
+#ifdef _WIN32
+    HANDLE file{ CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+        nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr) };
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER size{};
+    HANDLE mapping{};
+    if (GetFileSizeEx(file, &size) && size.QuadPart > 0)
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0,
+            nullptr);
+
+    if (mapping)
+    {
+        this->m_data = static_cast<const char*>(
+            MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        this->m_size = static_cast<std::size_t>(size.QuadPart);
+        CloseHandle(mapping);
+    }
+    CloseHandle(file);
+#else
+    int fd{ ::open(path.c_str(), O_RDONLY | O_CLOEXEC) };
+    if (fd < 0)
+        return false;
+
+    struct stat status{};
+    if (fstat(fd, &status) == 0 && status.st_size > 0)
+    {
+        void* data{ mmap(nullptr, static_cast<std::size_t>(status.st_size),
+            PROT_READ, MAP_PRIVATE, fd, 0) };
+        if (data != MAP_FAILED)
+        {
+            this->m_data = static_cast<const char*>(data);
+            this->m_size = static_cast<std::size_t>(status.st_size);
+        }
+    }
+    ::close(fd);
+#endif
+
+    if (!this->m_data)
+    {
+        std::cerr << "Error: Unable to map asset pack '" << path << "'\n";
+        this->m_size = 0;
+        return false;
+    }
+
+    if (!this->validate(path))
+    {
+        this->unmap();
+        return false;
+    }
+
+    return true;
+}
+
+void AssetPack::unmap() noexcept
+{
+    if (!this->m_data)
+        return;
+
+#ifdef _WIN32
+    UnmapViewOfFile(this->m_data);
+#else
+    munmap(const_cast<char*>(this->m_data), this->m_size);
+#endif
+
+    this->m_data = nullptr;
+    this->m_size = 0;
+}
+
+bool AssetPack::validate(const std::string& path) const noexcept
+{
+    auto reject = [&path](std::string_view reason) {
+        std::cerr << "Error: Asset pack '" << path << "' " << reason
+                  << ", using the loose files\n";
+        return false;
+    };
+
+    AssetPackHeader header{};
+    if (this->m_size < sizeof(header))
+        return reject("is truncated");
+    std::memcpy(&header, this->m_data, sizeof(header));
+
+    if (std::memcmp(header.magic, AssetPackHeader{}.magic,
+        sizeof(header.magic)) != 0)
+        return reject("is not an asset pack");
+    if (header.version != asset_pack_version)
+        return reject("has an unsupported version");
+    if (header.file_size != this->m_size)
+        return reject("is truncated");
+
+    std::size_t table_size{ header.entry_count * sizeof(AssetPackEntry) };
+    if (table_size > this->m_size - sizeof(header))
+        return reject("is truncated");
+    if (crc32(this->m_data + sizeof(header), table_size) !=
+        header.table_crc32)
+        return reject("has a corrupt table");
+
+    const auto* entries{ reinterpret_cast<const AssetPackEntry*>(
+        this->m_data + sizeof(header)) };
+    for (std::uint32_t i{ 0 }; i < header.entry_count; i++)
+    {
+        const AssetPackEntry& entry{ entries[i] };
+        if (entry.offset > this->m_size ||
+            entry.size >= this->m_size - entry.offset)
+            return reject("is truncated");
+        if (crc32(this->m_data + entry.offset, entry.size) != entry.crc32)
+            return reject("has a corrupt entry");
+    }
+
+    return true;
+}
+
+bool AssetPack::is_open() const noexcept
+{
+    return this->m_data != nullptr;
+}
+
+// Finds an entry by name with a binary search of the table. The contents
+// stay valid for as long as the pack is open.
+bool AssetPack::find(std::string_view name, std::string_view& contents) const
+noexcept
+{
+    if (!this->m_data)
+        return false;
+
+    AssetPackHeader header{};
+    std::memcpy(&header, this->m_data, sizeof(header));
+
+    const auto* begin{ reinterpret_cast<const AssetPackEntry*>(
+        this->m_data + sizeof(header)) };
+    const auto* end{ begin + header.entry_count };
+
+    const auto* found{ std::lower_bound(begin, end, name,
+        [](const AssetPackEntry& entry, std::string_view value) {
+            return std::string_view{ entry.name } < value;
+        }) };
+    if (found == end || std::string_view{ found->name } != name)
+        return false;
+
+    contents = std::string_view{ this->m_data + found->offset, found->size };
+    return true;
+}
+
+// Opened at startup and shared by everything loading assets
+AssetPack asset_pack{};
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Replaces the colors of every theme that has a record in the pack's palette
+void apply_palette(const AssetPack& pack) noexcept
+{
+    std::string_view palette{};
+    if (!pack.find("palette", palette))
+        return;
+
+    if (palette.size() % sizeof(PaletteRecord) != 0)
+    {
+        std::cerr << "Error: The palette in the asset pack is malformed\n";
+        return;
+    }
+
+    for (std::size_t offset{ 0 }; offset < palette.size();
+        offset += sizeof(PaletteRecord))
+    {
+        PaletteRecord record{};
+        std::memcpy(&record, palette.data() + offset, sizeof(record));
+        record.name[sizeof(record.name) - 1] = '\0';
+
+        for (Theme& theme : themes)
+        {
+            if (theme.name != record.name)
+                continue;
+
+            theme.clear_color = glm::vec3{ record.clear_color[0],
+                record.clear_color[1], record.clear_color[2] };
+            theme.circle_color = glm::vec3{ record.circle_color[0],
+                record.circle_color[1], record.circle_color[2] };
+            for (std::size_t hand{ 0 }; hand < 3; hand++)
+                theme.hand_colors[hand] = glm::vec3{
+                    record.hand_colors[hand][0], record.hand_colors[hand][1],
+                    record.hand_colors[hand][2] };
+        }
+    }
+}
+
+// Opens the asset pack and applies its palette on a thread of its own, so
+// that mapping and checking the pack overlaps creating the window and the GL
+// context. Nothing may touch asset_pack or the themes' colors until wait()
+// has returned.
+class AssetLoader
+{
+    std::thread m_thread{};
+    std::chrono::steady_clock::time_point m_begin{};
+    std::chrono::steady_clock::time_point m_end{};
+
+public:
+    AssetLoader() noexcept = default;
+    ~AssetLoader() noexcept;
+
+    AssetLoader(const AssetLoader&) = delete;
+    AssetLoader& operator=(const AssetLoader&) = delete;
+
+    void start(std::string) noexcept;
+    void wait() noexcept;
+
+    std::chrono::steady_clock::time_point get_begin() const noexcept;
+    std::chrono::steady_clock::time_point get_end() const noexcept;
+};
+
+AssetLoader::~AssetLoader() noexcept
+{
+    this->wait();
+}
+
+void AssetLoader::start(std::string path) noexcept
+{
+    this->m_thread = std::thread{ [this, path{ std::move(path) }]() {
+        this->m_begin = std::chrono::steady_clock::now();
+        if (asset_pack.open(path))
+            apply_palette(asset_pack);
+        this->m_end = std::chrono::steady_clock::now();
+    } };
+}
+
+void AssetLoader::wait() noexcept
+{
+    if (this->m_thread.joinable())
+        this->m_thread.join();
+}
+
+std::chrono::steady_clock::time_point AssetLoader::get_begin() const noexcept
+{
+    return this->m_begin;
+}
+
+std::chrono::steady_clock::time_point AssetLoader::get_end() const noexcept
+{
+    return this->m_end;
+}
+
+// Reads a whole file into `contents` with a single allocation and read
+bool read_file(const std::string& path, std::string& contents) noexcept
+{
+    std::ifstream file{ path, std::ios::in | std::ios::binary | std::ios::ate };
+    if (!file)
+        return false;
+
+    contents.resize(static_cast<std::size_t>(file.tellg()));
+    file.seekg(0);
+    return static_cast<bool>(file.read(contents.data(),
+        static_cast<std::streamsize>(contents.size())));
+}
+
+// Builds a pack at `path` from every .glsl file in `directory` and the
+// palette of the built-in themes
+bool build_asset_pack(const std::string& path,
+    const std::string& directory = ".") noexcept
+{
+    struct PendingEntry
+    {
+        std::string name;
+        std::string contents;
+    };
+
+    std::vector<PendingEntry> pending{};
+
+    std::error_code error{};
+    for (const auto& file :
+        std::filesystem::directory_iterator{ directory, error })
+    {
+        if (!file.is_regular_file() || file.path().extension() != ".glsl")
+            continue;
+
+        PendingEntry entry{ file.path().filename().string(), {} };
+        if (!read_file(file.path().string(), entry.contents))
+        {
+            std::cerr << "Error: Unable to read '" << file.path().string()
+                      << "'\n";
+            return false;
+        }
+        pending.push_back(std::move(entry));
+    }
+
+    if (error)
+    {
+        std::cerr << "Error: Unable to list '" << directory << "'\n";
+        return false;
+    }
+
+    PendingEntry palette{ "palette", {} };
+    for (const Theme& theme : themes)
+    {
+        PaletteRecord record{};
+        theme.name.copy(record.name, sizeof(record.name) - 1);
+        for (int i{ 0 }; i < 3; i++)
+        {
+            record.clear_color[i] = theme.clear_color[i];
+            record.circle_color[i] = theme.circle_color[i];
+            for (std::size_t hand{ 0 }; hand < 3; hand++)
+                record.hand_colors[hand][i] = theme.hand_colors[hand][i];
+        }
+
+        palette.contents.append(reinterpret_cast<const char*>(&record),
+            sizeof(record));
+    }
+    pending.push_back(std::move(palette));
+
+    std::sort(pending.begin(), pending.end(),
+        [](const PendingEntry& a, const PendingEntry& b) {
+            return a.name < b.name;
+        });
+
+    ////////////////////////////////////////////////////////////////////////////
+
+    AssetPackHeader header{};
+    header.version = asset_pack_version;
+    header.entry_count = static_cast<std::uint32_t>(pending.size());
+
+    std::vector<AssetPackEntry> entries(pending.size());
+    std::uint64_t offset{ sizeof(header) +
+        (entries.size() * sizeof(AssetPackEntry)) };
+
+    for (std::size_t i{ 0 }; i < pending.size(); i++)
+    {
+        if (pending[i].name.size() >= sizeof(entries[i].name))
+        {
+            std::cerr << "Error: Asset name '" << pending[i].name
+                      << "' is too long\n";
+            return false;
+        }
+
+        pending[i].name.copy(entries[i].name, sizeof(entries[i].name) - 1);
+        entries[i].offset = offset;
+        entries[i].size = static_cast<std::uint32_t>(
+            pending[i].contents.size());
+        entries[i].crc32 = crc32(pending[i].contents.data(),
+            pending[i].contents.size());
+
+        // A NUL after every entry, then padding up to the next 8 bytes
+        pending[i].contents.resize(
+            (pending[i].contents.size() + 8) & ~std::size_t{ 7 }, '\0');
+        offset += pending[i].contents.size();
+    }
+
+    header.file_size = offset;
+    header.table_crc32 = crc32(entries.data(),
+        entries.size() * sizeof(AssetPackEntry));
+
+    std::ofstream file{ path, std::ios::out | std::ios::binary |
+        std::ios::trunc };
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(entries.data()),
+        static_cast<std::streamsize>(entries.size() * sizeof(AssetPackEntry)));
+    for (const PendingEntry& entry : pending)
+        file.write(entry.contents.data(),
+            static_cast<std::streamsize>(entry.contents.size()));
+
+    if (!file)
+    {
+        std::cerr << "Error: Unable to write asset pack '" << path << "'\n";
+        return false;
+    }
+
+    std::cerr << "Packed " << pending.size() << " assets into '" << path
+              << "' (" << offset << " bytes)\n";
+    return true;
+}
+
+#endif
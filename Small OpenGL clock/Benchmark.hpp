@@ -0,0 +1,577 @@
+#include "ClockRenderer.hpp"
+#include "Framebuffer.hpp"
+#include "HeadlessContext.hpp"
+#include "ProgramCache.hpp"
+#include "RenderStats.hpp"
+#include "TimeService.hpp"
+#include "TimeZone.hpp"
+#include "WallAngles.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#pragma once
+
+#ifndef BENCHMARK_HPP
+#  define BENCHMARK_HPP
+
+// Runs `body` the given number of times and returns the mean cost of one call
+template <typename Function>
+double measure_ns_per_call(std::uint64_t iterations, Function body) noexcept
+{
+    auto begin{ std::chrono::steady_clock::now() };
+    for (std::uint64_t i{ 0 }; i < iterations; i++)
+        body();
+    auto end{ std::chrono::steady_clock::now() };
+
+    return std::chrono::duration<double, std::nano>(end - begin).count() /
+        static_cast<double>(iterations);
+}
+
+void print_benchmark_result(std::string_view name, double ns_per_call)
+noexcept
+{
+    std::cout << std::left << std::setw(32) << name << std::right
+              << std::fixed << std::setprecision(1) << std::setw(10)
+              << ns_per_call << " ns/call\n";
+}
+
+// Compares the per-frame std::localtime path with TimeService::snapshot
+void benchmark_time_service() noexcept
+{
+    constexpr std::uint64_t iterations{ 2'000'000 };
+    volatile std::int32_t sink{};
+
+    double localtime_ns{ measure_ns_per_call(iterations, [&sink]() {
+        std::time_t now_time{ std::chrono::system_clock::to_time_t(
+            std::chrono::system_clock::now()) };
+        std::tm local_tm{ *std::localtime(&now_time) };
+        sink = local_tm.tm_sec;
+    }) };
+
+    TimeService time_service{};
+    double snapshot_ns{ measure_ns_per_call(iterations,
+        [&sink, &time_service]() {
+        LocalTime local{ time_service.snapshot() };
+        sink = local.second;
+    }) };
+
+    print_benchmark_result("std::localtime", localtime_ns);
+    print_benchmark_result("TimeService::snapshot", snapshot_ns);
+}
+
+// Loads every zone of the tz database and compares looking up the offset
+// of all of them at the current time, which the cached interval answers,
+// with lookups at random instants that need the binary search, and with
+// what std::localtime costs for the one local zone
+bool benchmark_zones() noexcept
+{
+    const std::string& directory{ zone_database.get_directory() };
+    std::vector<const TimeZone*> zones{};
+    std::size_t transitions{};
+
+    auto begin{ std::chrono::steady_clock::now() };
+    std::error_code error{};
+    for (std::filesystem::recursive_directory_iterator entry{ directory,
+        error }, end{}; entry != end; entry.increment(error))
+    {
+        // Skips the copies of the database in posix/ and right/, and files
+        // like tzdata.zi that are not zones
+        std::string name{ std::filesystem::relative(entry->path(), directory,
+            error).generic_string() };
+        if (!entry->is_regular_file(error) ||
+            name.rfind("posix/", 0) == 0 || name.rfind("right/", 0) == 0)
+            continue;
+
+        if (const TimeZone* zone{ zone_database.load(name) })
+        {
+            zones.push_back(zone);
+            transitions += zone->get_transition_count();
+        }
+    }
+    auto end{ std::chrono::steady_clock::now() };
+
+    if (zones.empty())
+    {
+        std::cerr << "Error: No zones found in '" << directory << "'\n";
+        return false;
+    }
+
+    std::cout << std::left << std::setw(32) << "Zones loaded" << std::right
+              << std::setw(10) << zones.size() << " zones, " << transitions
+              << " transitions, " << std::fixed << std::setprecision(1)
+              << std::chrono::duration<double, std::milli>(
+                  end - begin).count()
+              << " ms\n";
+
+    constexpr std::uint64_t iterations{ 2'000'000 };
+    volatile std::int32_t sink{};
+
+    std::int64_t now{ static_cast<std::int64_t>(std::time(nullptr)) };
+    std::size_t next{ 0 };
+    double current_ns{ measure_ns_per_call(iterations,
+        [&sink, &zones, &next, now]() {
+        sink = zones[next]->utc_offset_at(now);
+        next = next + 1 == zones.size() ? 0 : next + 1;
+    }) };
+
+    // Instants from 1970 to 2100, drawn up front so the generator is not
+    // part of what is measured
+    std::mt19937_64 generator{ 1 };
+    std::uniform_int_distribution<std::int64_t> instants{ 0, 4'102'444'800 };
+    std::vector<std::int64_t> times(4096);
+    for (std::int64_t& time : times)
+        time = instants(generator);
+
+    next = 0;
+    std::size_t next_time{ 0 };
+    double random_ns{ measure_ns_per_call(iterations,
+        [&sink, &zones, &next, &times, &next_time]() {
+        sink = zones[next]->utc_offset_at(times[next_time]);
+        next = next + 1 == zones.size() ? 0 : next + 1;
+        next_time = (next_time + 1) & (times.size() - 1);
+    }) };
+
+    double localtime_ns{ measure_ns_per_call(iterations / 4, [&sink, now]() {
+        sink = TimeService::utc_offset_at(static_cast<std::time_t>(now));
+    }) };
+
+    print_benchmark_result("Zone offset, now", current_ns);
+    print_benchmark_result("Zone offset, random instant", random_ns);
+    print_benchmark_result("Local offset, std::localtime", localtime_ns);
+
+    return true;
+}
+
+// Compares the scalar hand angle kernel with the vector ones this CPU has,
+// for batches of 1,000 to 100,000 clocks at quarter hour offsets, and checks
+// that they all agree
+bool benchmark_wall_angles() noexcept
+{
+    struct Kernel
+    {
+        std::string_view name;
+        wall_angles_function function;
+    };
+
+    std::vector<Kernel> kernels{ { "Scalar", compute_wall_angles_scalar } };
+#ifdef WALL_ANGLES_X86
+    kernels.push_back({ "SSE2", compute_wall_angles_sse2 });
+    if (cpu_has_avx2())
+        kernels.push_back({ "AVX2", compute_wall_angles_avx2 });
+#endif
+
+    std::mt19937 generator{ 1 };
+    std::uniform_int_distribution<std::int32_t> quarter_hours{ -48, 56 };
+    constexpr std::int32_t day_seconds{ (10 * 3600) + (9 * 60) + 30 };
+    constexpr float subsecond{ 0.25f };
+    bool agree{ true };
+
+    for (std::size_t count : { 1'000, 10'000, 100'000 })
+    {
+        std::vector<std::int32_t> offsets(count);
+        for (std::int32_t& offset : offsets)
+            offset = quarter_hours(generator) * 900;
+
+        std::vector<std::uint16_t> expected(3 * count);
+        std::vector<std::uint16_t> result(3 * count);
+        compute_wall_angles_scalar(day_seconds, subsecond, offsets.data(),
+            count, WallAngleArrays{ expected.data(), expected.data() + count,
+                expected.data() + (2 * count) });
+
+        std::uint64_t iterations{ 50'000'000 / count };
+        for (const Kernel& kernel : kernels)
+        {
+            WallAngleArrays arrays{ result.data(), result.data() + count,
+                result.data() + (2 * count) };
+            double ns{ measure_ns_per_call(iterations,
+                [&kernel, &offsets, &arrays, count]() {
+                kernel.function(day_seconds, subsecond, offsets.data(), count,
+                    arrays);
+            }) };
+
+            agree = agree && std::memcmp(expected.data(), result.data(),
+                expected.size() * sizeof(std::uint16_t)) == 0;
+
+            std::cout << std::left << std::setw(32)
+                      << (std::string{ kernel.name } + ", " +
+                          std::to_string(count) + " clocks")
+                      << std::right << std::fixed << std::setprecision(1)
+                      << std::setw(10) << (ns / 1e3) << " us/batch"
+                      << std::setprecision(2) << std::setw(8)
+                      << (ns / static_cast<double>(count)) << " ns/clock\n";
+        }
+    }
+
+    if (!agree)
+        std::cerr << "Error: The kernels do not compute the same angles\n";
+    return agree;
+}
+
+struct FrameCost
+{
+    double gpu_milliseconds{};
+    double wall_milliseconds{};
+};
+
+// Mean cost of one frame drawn by `renderer` into `target`, as measured by
+// GL_TIME_ELAPSED and by the wall clock up to glFinish. Software rasterizers
+// like llvmpipe do most of their work outside the timer query, so only the
+// wall clock is meaningful there. The first frame builds whatever the
+// renderer caches and is not part of the result. With `resolved` set, every
+// frame is also resolved into it, as it would be before being shown.
+FrameCost measure_frame_cost(ClockRenderer& renderer,
+    const Framebuffer& target, int frames,
+    const Framebuffer* resolved = nullptr) noexcept
+{
+    HandAngles angles{ compute_hand_angles((10 * 3600) + (9 * 60) + 30.0) };
+    GpuTimer gpu_timer{};
+
+    target.bind();
+    renderer.draw(themes[0], angles, target.get_width(), target.get_height());
+    glFinish();
+
+    auto begin{ std::chrono::steady_clock::now() };
+    for (int frame{ 0 }; frame < frames; frame++)
+    {
+        gpu_timer.begin();
+        renderer.draw(themes[0], angles, target.get_width(),
+            target.get_height());
+        if (resolved)
+        {
+            target.resolve_into(*resolved);
+            target.bind();
+        }
+        gpu_timer.end();
+        glFinish();
+        gpu_timer.collect();
+    }
+    auto end{ std::chrono::steady_clock::now() };
+    gpu_timer.collect(true);
+
+    return FrameCost{ gpu_timer.get_mean_milliseconds(),
+        std::chrono::duration<double, std::milli>(end - begin).count() /
+            frames };
+}
+
+void print_frame_cost(std::string_view name, const FrameCost& cost) noexcept
+{
+    std::cout << std::left << std::setw(32) << name << std::right
+              << std::fixed << std::setprecision(1) << std::setw(10)
+              << (cost.gpu_milliseconds * 1e3) << " us GPU"
+              << std::setw(10) << (cost.wall_milliseconds * 1e3)
+              << " us wall\n";
+}
+
+// Compares the GPU time of a frame with the dial drawn by the circle shader
+// every frame against the cached dial, offscreen at a size where the fragment
+// work dominates
+bool benchmark_dial_cache() noexcept
+{
+    constexpr GLsizei size{ 2048 };
+    constexpr int frames{ 50 };
+
+    HeadlessContext context{};
+    if (!context.is_current())
+        return false;
+
+    ClockRenderer renderer{};
+    Framebuffer target{ size, size, 4 };
+
+    for (bool dial_cache : { false, true })
+    {
+        renderer.set_dial_cache(dial_cache);
+        print_frame_cost(dial_cache ? "Cached dial" : "Dial every frame",
+            measure_frame_cost(renderer, target, frames));
+    }
+
+    return true;
+}
+
+// Compares the original dial shader with the signed distance one for growing
+// numbers of ticks, drawing the dial every frame
+bool benchmark_dial_shader() noexcept
+{
+    constexpr GLsizei size{ 2048 };
+    constexpr int frames{ 50 };
+
+    struct DialSetup
+    {
+        std::string_view name;
+        DialShader shader;
+        int hour_ticks;
+        int minute_ticks;
+    };
+
+    constexpr std::array<DialSetup, 4> setups{ {
+        { "Legacy, 12 ticks", DialShader::legacy, 12, 0 },
+        { "SDF, 12 ticks", DialShader::sdf, 12, 0 },
+        { "SDF, 12 + 60 ticks", DialShader::sdf, 12, 60 },
+        { "SDF, 360 + 720 ticks", DialShader::sdf, 360, 720 }
+    } };
+
+    HeadlessContext context{};
+    if (!context.is_current())
+        return false;
+
+    ClockRenderer renderer{};
+    renderer.set_dial_cache(false);
+    Framebuffer target{ size, size, 4 };
+
+    for (const DialSetup& setup : setups)
+    {
+        renderer.set_dial_shader(setup.shader);
+        renderer.set_dial_ticks(setup.hour_ticks, setup.minute_ticks);
+        print_frame_cost(setup.name,
+            measure_frame_cost(renderer, target, frames));
+    }
+
+    return true;
+}
+
+// Counts the fragments the dial shader runs for at 4K with the full-screen
+// quad and with the dial ring, and what drawing the dial every frame costs
+// with each
+bool benchmark_dial_overdraw() noexcept
+{
+    constexpr GLsizei width{ 3840 };
+    constexpr GLsizei height{ 2160 };
+    constexpr int frames{ 10 };
+
+    HeadlessContext context{};
+    if (!context.is_current())
+        return false;
+
+    ClockRenderer renderer{ Antialiasing::msaa, 12, 60 };
+    renderer.set_dial_cache(false);
+
+    Framebuffer counting_target{ width, height };
+    Framebuffer target{ width, height, 4 };
+
+    for (DialGeometry geometry : { DialGeometry::quad, DialGeometry::annulus })
+    {
+        std::string_view name{
+            geometry == DialGeometry::quad ? "Quad" : "Ring" };
+        renderer.set_dial_geometry(geometry);
+
+        counting_target.bind();
+        GLuint64 fragments{ renderer.count_dial_fragments(width, height) };
+
+        std::cout << std::left << std::setw(32) << name << std::right
+                  << std::setw(10) << fragments << " fragments ("
+                  << std::fixed << std::setprecision(1)
+                  << ((100.0 * static_cast<double>(fragments)) /
+                      (static_cast<double>(width) * height))
+                  << " % of the screen)\n";
+
+        print_frame_cost(name, measure_frame_cost(renderer, target, frames));
+    }
+
+    return true;
+}
+
+// Compares 4x MSAA, including the resolve every frame needs, with analytic
+// antialiasing into a single-sampled target
+bool benchmark_antialiasing() noexcept
+{
+    constexpr GLsizei size{ 2048 };
+    constexpr int frames{ 50 };
+
+    HeadlessContext context{};
+    if (!context.is_current())
+        return false;
+
+    for (Antialiasing antialiasing :
+        { Antialiasing::msaa, Antialiasing::analytic })
+    {
+        ClockRenderer renderer{ antialiasing, 12, 60 };
+
+        GLsizei samples{ renderer.get_samples() };
+        Framebuffer target{ size, size, samples };
+        Framebuffer resolved{ size, size };
+
+        std::string_view name{
+            antialiasing == Antialiasing::msaa ? "4x MSAA" : "Analytic" };
+        double megabytes{ (static_cast<double>(size) * size * 4.0 *
+            std::max<GLsizei>(samples, 1)) / (1024.0 * 1024.0) };
+
+        std::cout << std::left << std::setw(32) << name << std::right
+                  << std::fixed << std::setprecision(1) << std::setw(10)
+                  << megabytes << " MiB color buffer\n";
+
+        print_frame_cost(name, measure_frame_cost(renderer, target, frames,
+            samples > 0 ? &resolved : nullptr));
+    }
+
+    return true;
+}
+
+// Draws walls of 1 up to 10,000 clocks with the dial drawn every frame, which
+// takes the same two instanced draws at any size. Every clock is a quarter
+// of an hour ahead of the one before it.
+bool benchmark_wall() noexcept
+{
+    constexpr GLsizei size{ 2048 };
+    constexpr int frames{ 5 };
+
+    HeadlessContext context{};
+    if (!context.is_current())
+        return false;
+
+    ClockRenderer renderer{};
+    renderer.set_dial_cache(false);
+    Framebuffer target{ size, size, renderer.get_samples() };
+
+    for (std::size_t count : { 1, 10, 100, 1'000, 10'000 })
+    {
+        std::vector<WallClock> clocks(count);
+        for (std::size_t i{ 0 }; i < count; i++)
+            clocks[i].utc_offset = static_cast<std::int32_t>((i % 96) * 900);
+        layout_wall_grid(clocks);
+        renderer.set_wall(std::move(clocks));
+
+        FrameCost cost{ measure_frame_cost(renderer, target, frames) };
+
+        std::cout << std::left << std::setw(32)
+                  << ("Wall, " + std::to_string(count) +
+                      (count == 1 ? " clock" : " clocks"))
+                  << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(10) << (cost.gpu_milliseconds * 1e3)
+                  << " us GPU" << std::setw(10)
+                  << (cost.wall_milliseconds * 1e3) << " us wall"
+                  << std::setw(4) << renderer.get_draw_calls()
+                  << " draws\n";
+    }
+
+    return true;
+}
+
+// Compares setting a uniform through a location queried by name on every
+// call with the name lookup in ShaderProgram and with a resolved handle
+bool benchmark_uniform_setters() noexcept
+{
+    constexpr std::uint64_t iterations{ 1'000'000 };
+
+    HeadlessContext context{};
+    if (!context.is_current())
+        return false;
+
+    ShaderProgram program{ "dial-vertex.glsl", "dial-fragment.glsl" };
+    program.activate_program();
+
+    GLuint program_id{ program.get_program_id() };
+    double location_query_ns{ measure_ns_per_call(iterations, [program_id]() {
+        glUniform1i(glGetUniformLocation(program_id, "dial_texture"), 0);
+    }) };
+
+    double name_lookup_ns{ measure_ns_per_call(iterations, [&program]() {
+        program.set_int("dial_texture", 0);
+    }) };
+
+    Uniform dial_texture{ program.get_uniform("dial_texture") };
+    double handle_ns{ measure_ns_per_call(iterations,
+        [&program, dial_texture]() {
+        program.set_int(dial_texture, 0);
+    }) };
+
+    print_benchmark_result("glGetUniformLocation + set", location_query_ns);
+    print_benchmark_result("Set by name", name_lookup_ns);
+    print_benchmark_result("Set by handle", handle_ns);
+
+    return true;
+}
+
+// Times creating the renderer, which compiles and links every shader it
+// starts with, first with an empty shader cache and then with the binaries
+// that run left behind. Drivers like Mesa keep a shader cache of their own,
+// which may already take the edge off the cold start.
+bool benchmark_startup() noexcept
+{
+    HeadlessContext context{};
+    if (!context.is_current())
+        return false;
+
+    if (!program_cache.is_supported())
+    {
+        std::cerr << "Error: The driver has no program binary formats\n";
+        return false;
+    }
+
+    enable_parallel_shader_compile(context.get_loader());
+
+    std::error_code error{};
+    std::filesystem::path directory{
+        std::filesystem::temp_directory_path(error) / "clock-shader-cache" };
+    std::filesystem::remove_all(directory, error);
+    program_cache.set_directory(directory.string());
+
+    for (bool warm : { false, true })
+    {
+        program_cache.reset_stats();
+
+        auto begin{ std::chrono::steady_clock::now() };
+        {
+            ClockRenderer renderer{};
+            glFinish();
+        }
+        auto end{ std::chrono::steady_clock::now() };
+
+        const ProgramCacheStats& stats{ program_cache.get_stats() };
+        std::cout << std::left << std::setw(32)
+                  << (warm ? "Warm shader cache" : "Cold shader cache")
+                  << std::right << std::fixed << std::setprecision(2)
+                  << std::setw(10)
+                  << std::chrono::duration<double, std::milli>(
+                      end - begin).count()
+                  << " ms (" << stats.loaded << " loaded, " << stats.compiled
+                  << " compiled)\n";
+    }
+
+    std::filesystem::remove_all(directory, error);
+    return true;
+}
+
+bool run_benchmark(std::string_view name) noexcept
+{
+    if (name == "time")
+    {
+        benchmark_time_service();
+        return true;
+    }
+    if (name == "dial")
+        return benchmark_dial_cache();
+    if (name == "uniform")
+        return benchmark_uniform_setters();
+    if (name == "dial-shader")
+        return benchmark_dial_shader();
+    if (name == "overdraw")
+        return benchmark_dial_overdraw();
+    if (name == "aa")
+        return benchmark_antialiasing();
+    if (name == "startup")
+        return benchmark_startup();
+    if (name == "wall")
+        return benchmark_wall();
+    if (name == "zones")
+        return benchmark_zones();
+    if (name == "angles")
+        return benchmark_wall_angles();
+
+    std::cerr << "Error: Unknown benchmark '" << name << "'\n";
+    return false;
+}
+
+#endif
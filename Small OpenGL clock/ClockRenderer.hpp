@@ -0,0 +1,991 @@
+#include "ClockTicker.hpp"
+#include "ClockWall.hpp"
+#include "Framebuffer.hpp"
+#include "ShaderClass.hpp"
+#include "Theme.hpp"
+#include "VertexFormat.hpp"
+#include "WallAngles.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#pragma once
+
+#ifndef CLOCK_RENDERER_HPP
+#  define CLOCK_RENDERER_HPP
+
+// The dial quad and ring are flat and within the unit square, so their
+// positions are two normalized shorts; the shaders still read a vec3, with
+// z filled in as 0
+struct DialVertex
+{
+    GLshort position[2]{};
+};
+
+const VertexFormat dial_vertex_format{
+    { { 0, 2, GL_SHORT, GL_TRUE, offsetof(DialVertex, position) } },
+    sizeof(DialVertex) };
+
+std::array<DialVertex, 4> quad_vertices{ {
+    { { to_snorm16( 1.0f), to_snorm16( 1.0f) } },
+    { { to_snorm16( 1.0f), to_snorm16(-1.0f) } },
+    { { to_snorm16(-1.0f), to_snorm16(-1.0f) } },
+    { { to_snorm16(-1.0f), to_snorm16( 1.0f) } }
+} };
+
+std::array<GLuint, 6> quad_indices{
+    0, 1, 2,
+    3, 0, 2
+};
+
+// The dial ring has to cover everything circle-fragment.glsl can draw: the
+// ticks start no further in than line_length or the minute ticks, nothing
+// reaches further out than the rim, and both get a soft edge. Keep these in
+// step with the constants in the shader.
+constexpr GLfloat dial_minute_tick_length{ 0.05f };
+constexpr GLfloat dial_ring_margin{ 0.02f };
+constexpr GLuint dial_ring_segments{ 128 };
+
+// Appends a ring of quads between two radii to a mesh. The outer vertices are
+// pushed out so the polygon still contains the outer circle.
+void append_annulus(GLfloat inner_radius, GLfloat outer_radius,
+    GLuint segments, std::vector<DialVertex>& vertices,
+    std::vector<GLuint>& indices) noexcept
+{
+    constexpr double pi{ 3.14159265358979323846 };
+
+    GLuint first{ static_cast<GLuint>(vertices.size()) };
+    double outer{ outer_radius / std::cos(pi / segments) };
+
+    for (GLuint segment{ 0 }; segment < segments; segment++)
+    {
+        double angle{ (2.0 * pi * segment) / segments };
+        double x{ std::cos(angle) };
+        double y{ std::sin(angle) };
+
+        vertices.push_back({ {
+            to_snorm16(static_cast<float>(x * inner_radius)),
+            to_snorm16(static_cast<float>(y * inner_radius)) } });
+        vertices.push_back({ {
+            to_snorm16(static_cast<float>(x * outer)),
+            to_snorm16(static_cast<float>(y * outer)) } });
+
+        GLuint inner_vertex{ first + (segment * 2) };
+        GLuint next_vertex{ first + (((segment + 1) % segments) * 2) };
+
+        indices.insert(indices.end(), {
+            inner_vertex, inner_vertex + 1, next_vertex + 1,
+            inner_vertex, next_vertex + 1, next_vertex });
+    }
+}
+
+// One triangle shared by all hands; z marks the tip, which the vertex shader
+// moves out to the length of each hand. Its three vertices stay floats:
+// 0.04 has no exact 16-bit fraction, and rounding it moves the hand edges
+// by a visible fraction of a pixel.
+struct HandVertex
+{
+    GLfloat position[3]{};
+};
+
+const VertexFormat hand_vertex_format{
+    { { 0, 3, GL_FLOAT, GL_FALSE, offsetof(HandVertex, position) } },
+    sizeof(HandVertex) };
+
+std::array<HandVertex, 3> hand_vertices{ {
+    { { -0.04f, -0.04f, 0.0f } },
+    { {  0.04f, -0.04f, 0.0f } },
+    { {  0.0f,   0.0f,  1.0f } }
+} };
+
+// Seconds, minutes and hours hand, in that order
+std::array<GLfloat, 3> hand_lengths{ 0.8f, 0.6f, 0.4f };
+
+// Mirror of the std140 ClockState uniform block in the shaders. Everything up
+// to time_of_day only changes with the theme; the time of day is the one
+// range written every frame.
+struct ClockState
+{
+    glm::mat4 model{ 1.0f };
+    glm::vec3 circle_color{};
+    float rim_thickness{};
+    std::array<glm::vec4, 3> hand_colors{};
+    glm::vec4 hand_lengths{};
+    float radius{};
+    float line_length{};
+    GLint hour_ticks{};
+    GLint minute_ticks{};
+    GLint analytic_aa{};
+    float padding0{};
+    glm::vec2 time_of_day{};
+};
+
+static_assert(offsetof(ClockState, hand_colors) == 80,
+    "ClockState does not match the std140 layout");
+static_assert(offsetof(ClockState, time_of_day) == 168,
+    "ClockState does not match the std140 layout");
+static_assert(sizeof(ClockState) == 176,
+    "ClockState does not match the std140 layout");
+
+// Per-instance attribute of every clock on a wall, read by the INSTANCED
+// variants of the dial and hand shaders, and set with the wall: the center
+// and scale in wall units, all within [-1, 1], as normalized shorts. The
+// instance buffer holds one of these per clock, followed by the angles of
+// the second, minute and hour hands of all clocks as three arrays of
+// normalized unsigned shorts (see WallAngleArrays), which are rewritten
+// together whenever the time shown changes.
+struct WallInstance
+{
+    GLshort position[2]{};
+    GLshort scale{};
+    GLshort padding{};
+};
+
+const VertexFormat wall_instance_format{
+    { { 1, 3, GL_SHORT, GL_TRUE, offsetof(WallInstance, position) } },
+    sizeof(WallInstance) };
+
+// A full turn of each hand as a fraction of 65535, which is finer than a
+// pixel at the tip of a hand across a 4K screen
+using WallAngle = std::uint16_t;
+
+enum class Antialiasing
+{
+    // 4x multisampling, resolved before the frame is shown or read back
+    msaa,
+    // One sample per pixel; the shaders work out how much of each pixel they
+    // cover and blend with premultiplied alpha
+    analytic
+};
+
+// Samples per pixel every framebuffer drawn into has to have
+GLsizei antialiasing_samples(Antialiasing antialiasing) noexcept
+{
+    return antialiasing == Antialiasing::msaa ? 4 : 0;
+}
+
+enum class DialShader
+{
+    // Signed distance to the rim and ticks, any number of ticks
+    sdf,
+    // The original chain of slope comparisons, 12 ticks only; kept to
+    // compare against
+    legacy
+};
+
+enum class DialGeometry
+{
+    // A ring just wide enough for the rim and ticks
+    annulus,
+    // The whole viewport, most of which the dial shader discards; kept to
+    // compare against
+    quad
+};
+
+// Draws the dial and the three hands into whatever framebuffer is bound, so
+// the window and the headless path render exactly the same picture. Needs a
+// current GL context for its whole lifetime.
+//
+// The dial never changes between frames, so by default it is rendered once
+// into a multisampled framebuffer, resolved into a texture and from then on
+// only copied with one texel fetch per pixel. The cache is rebuilt when the
+// size or the theme changes.
+//
+// With a wall of clocks set, it draws every dial in one instanced draw and
+// every hand in another, whatever the number of clocks. The dials of the
+// whole wall are cached together like the single one.
+class ClockRenderer
+{
+    // Dial and hand programs specialized for the antialiasing mode and the
+    // tick counts, with the variant in use picked again when those change
+    ShaderVariants m_circle_programs;
+    ShaderVariants m_triangle_programs;
+    ShaderProgram* m_circle_program{};
+    ShaderProgram* m_triangle_program{};
+    ShaderProgram m_dial_program;
+    std::unique_ptr<ShaderProgram> m_legacy_circle_program{};
+    std::unique_ptr<ShaderProgram> m_flat_program{};
+
+    // Programs rebuilt from changed sources, swapped in together once every
+    // one of them has linked
+    std::unique_ptr<ShaderProgram> m_reloaded_circle_program{};
+    std::unique_ptr<ShaderProgram> m_reloaded_triangle_program{};
+    std::unique_ptr<ShaderProgram> m_reloaded_legacy_circle_program{};
+    ShaderDefines m_reloaded_circle_defines{};
+    ShaderDefines m_reloaded_triangle_defines{};
+
+    DialShader m_dial_shader{ DialShader::sdf };
+    DialGeometry m_dial_geometry{ DialGeometry::annulus };
+    Antialiasing m_antialiasing;
+
+    static constexpr GLuint m_state_binding{ 0 };
+
+    GLuint m_VAOs[2]{};
+    GLuint m_VBOs[2]{};
+    GLuint m_EBO{};
+    GLuint m_UBO{};
+
+    // The dial ring and the hand with the wall instances attached, and the
+    // buffer holding those
+    GLuint m_wall_VAOs[2]{};
+    GLuint m_wall_VBO{};
+
+    // The first VBO and the EBO hold the full-screen quad followed by the
+    // dial ring
+    GLsizei m_dial_ring_index_count{};
+
+    float m_radius{ 0.9f };
+    float m_line_length{ 0.75f };
+    float m_rim_thickness{ 0.009f };
+    int m_hour_ticks{ 12 };
+    int m_minute_ticks{ 0 };
+
+    bool m_dial_cache_enabled{ true };
+    std::unique_ptr<Framebuffer> m_dial_multisampled{};
+    std::unique_ptr<Framebuffer> m_dial{};
+    glm::vec3 m_dial_clear_color{};
+    glm::vec3 m_dial_circle_color{};
+    bool m_dial_stale{ false };
+
+    // What was last written to the uniform buffer, so the theme and dial part
+    // is only uploaded again when it changes
+    ClockState m_state{};
+    bool m_state_changed{ true };
+
+    // The UTC offset of every clock on the wall, looked up again every
+    // second, and the time the hand angles in the instance buffer are for
+    std::vector<WallClock> m_wall{};
+    std::vector<std::int32_t> m_wall_offsets{};
+    std::int64_t m_wall_second{ std::numeric_limits<std::int64_t>::min() };
+    float m_wall_subsecond{};
+
+    // Draw calls issued by the last draw(), dial cache updates included
+    int m_draw_calls{};
+
+    static void bind_clock_state(ShaderProgram&) noexcept;
+    ShaderDefines get_circle_defines() const noexcept;
+    ShaderDefines get_triangle_defines() const noexcept;
+    ShaderProgram& get_circle_program() noexcept;
+    ShaderProgram& get_triangle_program() noexcept;
+
+    void upload_dial_mesh() noexcept;
+    void upload_wall() noexcept;
+    void draw_dial_geometry() const noexcept;
+    void draw_wall_dials() noexcept;
+    void update_wall(const HandAngles&, int, int) noexcept;
+    void draw_dial(const Theme&) noexcept;
+    bool is_dial_cache_stale(const Theme&, int, int) const noexcept;
+    void update_dial_cache(const Theme&, int, int) noexcept;
+    void update_shared_state(const Theme&) noexcept;
+
+public:
+    explicit ClockRenderer(Antialiasing = Antialiasing::msaa, int = 12,
+        int = 0, std::vector<WallClock> = {}) noexcept;
+    ~ClockRenderer() noexcept;
+
+    ClockRenderer(const ClockRenderer&) = delete;
+    ClockRenderer& operator=(const ClockRenderer&) = delete;
+
+    void set_dial_cache(bool) noexcept;
+    bool get_dial_cache() const noexcept;
+
+    void set_dial_ticks(int, int) noexcept;
+    void set_rim_thickness(float) noexcept;
+    void set_dial_shader(DialShader) noexcept;
+    void set_dial_geometry(DialGeometry) noexcept;
+
+    GLuint64 count_dial_fragments(int, int) noexcept;
+
+    void set_wall(std::vector<WallClock>) noexcept;
+    std::size_t get_wall_size() const noexcept;
+    int get_draw_calls() const noexcept;
+
+    void reload_shaders() noexcept;
+    bool is_reloading_shaders() const noexcept;
+    bool update_reloaded_shaders() noexcept;
+
+    GLsizei get_samples() const noexcept;
+
+    void draw(const Theme&, const HandAngles&, int, int) noexcept;
+};
+
+// The tick counts and the wall are taken here rather than through
+// set_dial_ticks() and set_wall(), so the variants compiled up front are
+// the ones the first frame uses
+ClockRenderer::ClockRenderer(Antialiasing antialiasing, int hour_ticks,
+    int minute_ticks, std::vector<WallClock> wall) noexcept :
+    m_circle_programs{ "circle-vertex.glsl", "circle-fragment.glsl",
+        bind_clock_state },
+    m_triangle_programs{ "triangle-vertex.glsl", "triangle-fragment.glsl",
+        bind_clock_state },
+    m_dial_program{ "dial-vertex.glsl", "dial-fragment.glsl" },
+    m_antialiasing{ antialiasing },
+    m_hour_ticks{ hour_ticks },
+    m_minute_ticks{ minute_ticks },
+    m_wall{ std::move(wall) }
+{
+    // Issued before anything else, so they compile while the buffers are
+    // being set up
+    this->m_circle_programs.prepare(this->get_circle_defines());
+    this->m_triangle_programs.prepare(this->get_triangle_defines());
+
+    glGenVertexArrays(2, this->m_VAOs);
+    glGenBuffers(2, this->m_VBOs);
+    glGenBuffers(1, &this->m_EBO);
+    glGenBuffers(1, &this->m_UBO);
+    glGenVertexArrays(2, this->m_wall_VAOs);
+    glGenBuffers(1, &this->m_wall_VBO);
+
+    ////////////////////////////////////////////////////////////////////////////
+
+    glBindVertexArray(this->m_VAOs[0]);
+    glBindBuffer(GL_ARRAY_BUFFER, this->m_VBOs[0]);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->m_EBO);
+    this->upload_dial_mesh();
+    dial_vertex_format.apply();
+
+    ////////////////////////////////////////////////////////////////////////////
+
+    glBindVertexArray(this->m_VAOs[1]);
+    glBindBuffer(GL_ARRAY_BUFFER, this->m_VBOs[1]);
+    glBufferData(GL_ARRAY_BUFFER, hand_vertices.size() * sizeof(HandVertex),
+        hand_vertices.data(), GL_STATIC_DRAW);
+    hand_vertex_format.apply();
+
+    ////////////////////////////////////////////////////////////////////////////
+
+    // The same meshes once more, for the wall; set_wall() attaches the
+    // instances
+    for (GLuint wall_VAO{ 0 }; wall_VAO < 2; wall_VAO++)
+    {
+        glBindVertexArray(this->m_wall_VAOs[wall_VAO]);
+        glBindBuffer(GL_ARRAY_BUFFER, this->m_VBOs[wall_VAO]);
+        if (wall_VAO == 0)
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->m_EBO);
+
+        (wall_VAO == 0 ? dial_vertex_format : hand_vertex_format).apply();
+    }
+    this->upload_wall();
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    ////////////////////////////////////////////////////////////////////////////
+
+    this->m_state.radius = this->m_radius;
+    this->m_state.line_length = this->m_line_length;
+    this->m_state.rim_thickness = this->m_rim_thickness;
+    this->m_state.hour_ticks = this->m_hour_ticks;
+    this->m_state.minute_ticks = this->m_minute_ticks;
+    this->m_state.analytic_aa = antialiasing == Antialiasing::analytic;
+    this->m_state.hand_lengths =
+        glm::vec4{ hand_lengths[0], hand_lengths[1], hand_lengths[2], 0.0f };
+
+    glBindBuffer(GL_UNIFORM_BUFFER, this->m_UBO);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(ClockState), &this->m_state,
+        GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, m_state_binding, this->m_UBO);
+
+    this->m_dial_program.activate_program();
+    this->m_dial_program.set_int("dial_texture", 0);
+    glUseProgram(0);
+
+    if (antialiasing == Antialiasing::msaa)
+        glEnable(GL_MULTISAMPLE);
+    else
+    {
+        glDisable(GL_MULTISAMPLE);
+        glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    }
+}
+
+ClockRenderer::~ClockRenderer() noexcept
+{
+    glDeleteVertexArrays(2, this->m_VAOs);
+    glDeleteBuffers(2, this->m_VBOs);
+    glDeleteBuffers(1, &this->m_EBO);
+    glDeleteBuffers(1, &this->m_UBO);
+    glDeleteVertexArrays(2, this->m_wall_VAOs);
+    glDeleteBuffers(1, &this->m_wall_VBO);
+}
+
+// Turning the cache off draws the dial with the full circle shader every
+// frame again, which is only useful to compare the two
+void ClockRenderer::set_dial_cache(bool enabled) noexcept
+{
+    this->m_dial_cache_enabled = enabled;
+    if (!enabled)
+    {
+        this->m_dial_multisampled.reset();
+        this->m_dial.reset();
+    }
+}
+
+bool ClockRenderer::get_dial_cache() const noexcept
+{
+    return this->m_dial_cache_enabled;
+}
+
+// Hour ticks run from line_length to the rim, minute ticks are short ones at
+// the rim; a count of 0 leaves them out
+void ClockRenderer::set_dial_ticks(int hour_ticks, int minute_ticks) noexcept
+{
+    this->m_hour_ticks = hour_ticks;
+    this->m_minute_ticks = minute_ticks;
+    this->m_circle_program = nullptr;
+    this->m_state.hour_ticks = hour_ticks;
+    this->m_state.minute_ticks = minute_ticks;
+    this->m_state_changed = true;
+    this->m_dial_stale = true;
+}
+
+void ClockRenderer::set_rim_thickness(float thickness) noexcept
+{
+    this->m_rim_thickness = thickness;
+    this->m_state.rim_thickness = thickness;
+    this->m_state_changed = true;
+    this->m_dial_stale = true;
+
+    glBindVertexArray(this->m_VAOs[0]);
+    glBindBuffer(GL_ARRAY_BUFFER, this->m_VBOs[0]);
+    this->upload_dial_mesh();
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void ClockRenderer::set_dial_shader(DialShader shader) noexcept
+{
+    if (shader == DialShader::legacy && !this->m_legacy_circle_program)
+    {
+        this->m_legacy_circle_program = std::make_unique<ShaderProgram>(
+            "circle-vertex.glsl", "circle-legacy-fragment.glsl");
+        bind_clock_state(*this->m_legacy_circle_program);
+    }
+
+    this->m_dial_shader = shader;
+    this->m_dial_stale = true;
+}
+
+// Starts rebuilding the dial and hand programs from their current sources,
+// replacing a rebuild that is still running. Only the compiles and links are
+// issued here; update_reloaded_shaders() swaps the programs in.
+void ClockRenderer::reload_shaders() noexcept
+{
+    this->m_reloaded_circle_defines = this->get_circle_defines();
+    this->m_reloaded_triangle_defines = this->get_triangle_defines();
+    this->m_reloaded_circle_program =
+        this->m_circle_programs.build(this->m_reloaded_circle_defines);
+    this->m_reloaded_triangle_program =
+        this->m_triangle_programs.build(this->m_reloaded_triangle_defines);
+
+    if (this->m_legacy_circle_program)
+        this->m_reloaded_legacy_circle_program =
+            std::make_unique<ShaderProgram>("circle-vertex.glsl",
+                "circle-legacy-fragment.glsl");
+}
+
+bool ClockRenderer::is_reloading_shaders() const noexcept
+{
+    return this->m_reloaded_circle_program != nullptr;
+}
+
+// Call between frames. Once every rebuilt program has linked, they all
+// replace the ones in use at once and true is returned, since the picture
+// may have changed. With parallel shader compiles this never waits for the
+// driver and just tries again on a later call; without them it waits for
+// the links here. If any program fails, all of them are dropped and the
+// ones in use are kept.
+bool ClockRenderer::update_reloaded_shaders() noexcept
+{
+    if (!this->is_reloading_shaders())
+        return false;
+
+    std::array<std::unique_ptr<ShaderProgram>*, 3> reloaded{
+        &this->m_reloaded_circle_program,
+        &this->m_reloaded_triangle_program,
+        &this->m_reloaded_legacy_circle_program };
+
+    for (std::unique_ptr<ShaderProgram>* program : reloaded)
+    {
+        if (*program && parallel_shader_compile &&
+            !(*program)->is_link_complete())
+            return false;
+    }
+
+    bool linked{ true };
+    for (std::unique_ptr<ShaderProgram>* program : reloaded)
+    {
+        if (*program && !(*program)->is_linked())
+            linked = false;
+    }
+
+    if (!linked)
+    {
+        std::cerr << "Error: Keeping the previous shaders\n";
+        for (std::unique_ptr<ShaderProgram>* program : reloaded)
+            program->reset();
+        return false;
+    }
+
+    // Other variants of the same shaders are built again from the new
+    // sources when they are needed
+    this->m_circle_programs.replace_all(this->m_reloaded_circle_defines,
+        std::move(this->m_reloaded_circle_program));
+    this->m_triangle_programs.replace_all(this->m_reloaded_triangle_defines,
+        std::move(this->m_reloaded_triangle_program));
+    this->m_circle_program = nullptr;
+    this->m_triangle_program = nullptr;
+
+    if (this->m_reloaded_legacy_circle_program)
+    {
+        bind_clock_state(*this->m_reloaded_legacy_circle_program);
+        *this->m_legacy_circle_program =
+            std::move(*this->m_reloaded_legacy_circle_program);
+        this->m_reloaded_legacy_circle_program.reset();
+    }
+
+    // Shares the vertex shader, so it is simply built again when needed
+    this->m_flat_program.reset();
+    this->m_dial_stale = true;
+    return true;
+}
+
+void ClockRenderer::bind_clock_state(ShaderProgram& program) noexcept
+{
+    program.set_uniform_block_binding("ClockState", m_state_binding);
+}
+
+// The settings the dial shader is specialized for; anything not defined
+// here it reads from ClockState instead
+ShaderDefines ClockRenderer::get_circle_defines() const noexcept
+{
+    ShaderDefines defines{
+        { "ANALYTIC_AA",
+            this->m_antialiasing == Antialiasing::analytic ? "true" : "false" },
+        { "HOUR_TICKS", std::to_string(this->m_hour_ticks) },
+        { "MINUTE_TICKS", std::to_string(this->m_minute_ticks) }
+    };
+    if (!this->m_wall.empty())
+        defines.emplace("INSTANCED", "1");
+
+    return defines;
+}
+
+ShaderDefines ClockRenderer::get_triangle_defines() const noexcept
+{
+    ShaderDefines defines{
+        { "ANALYTIC_AA",
+            this->m_antialiasing == Antialiasing::analytic ? "true" : "false" }
+    };
+    if (!this->m_wall.empty())
+        defines.emplace("INSTANCED", "1");
+
+    return defines;
+}
+
+ShaderProgram& ClockRenderer::get_circle_program() noexcept
+{
+    if (!this->m_circle_program)
+        this->m_circle_program =
+            &this->m_circle_programs.get(this->get_circle_defines());
+
+    return *this->m_circle_program;
+}
+
+ShaderProgram& ClockRenderer::get_triangle_program() noexcept
+{
+    if (!this->m_triangle_program)
+        this->m_triangle_program =
+            &this->m_triangle_programs.get(this->get_triangle_defines());
+
+    return *this->m_triangle_program;
+}
+
+GLsizei ClockRenderer::get_samples() const noexcept
+{
+    return antialiasing_samples(this->m_antialiasing);
+}
+
+void ClockRenderer::set_dial_geometry(DialGeometry geometry) noexcept
+{
+    this->m_dial_geometry = geometry;
+}
+
+// Number of samples the dial geometry covers in a viewport of the given size,
+// which is how many times the dial fragment shader runs per sample. Counted
+// with an occlusion query around a flat shader that never discards, since
+// discarded fragments would not be counted.
+GLuint64 ClockRenderer::count_dial_fragments(int width, int height) noexcept
+{
+    if (!this->m_flat_program)
+    {
+        this->m_flat_program = std::make_unique<ShaderProgram>(
+            "circle-vertex.glsl", "flat-fragment.glsl");
+        bind_clock_state(*this->m_flat_program);
+    }
+
+    GLuint query{};
+    GLuint64 samples{};
+    glGenQueries(1, &query);
+
+    glViewport(0, 0, width, height);
+    this->m_flat_program->activate_program();
+
+    glBeginQuery(GL_SAMPLES_PASSED, query);
+    this->draw_dial_geometry();
+    glEndQuery(GL_SAMPLES_PASSED);
+
+    glGetQueryObjectui64v(query, GL_QUERY_RESULT, &samples);
+    glDeleteQueries(1, &query);
+
+    return samples;
+}
+
+// Replaces the single clock with a wall of clocks, or goes back to the single
+// clock with an empty wall. The clocks keep their place until the next call.
+void ClockRenderer::set_wall(std::vector<WallClock> clocks) noexcept
+{
+    this->m_wall = std::move(clocks);
+    this->upload_wall();
+
+    // The single clock is drawn without any transform
+    if (this->m_wall.empty())
+        this->m_state.model = glm::mat4{ 1.0f };
+
+    this->m_circle_program = nullptr;
+    this->m_triangle_program = nullptr;
+    this->m_state_changed = true;
+    this->m_dial_stale = true;
+}
+
+// Fills the instance buffer from the clocks on the wall and attaches it to
+// the wall VAOs
+void ClockRenderer::upload_wall() noexcept
+{
+    this->m_wall_offsets.resize(this->m_wall.size());
+
+    std::vector<WallInstance> instances(this->m_wall.size());
+    for (std::size_t i{ 0 }; i < this->m_wall.size(); i++)
+    {
+        instances[i].position[0] = to_snorm16(this->m_wall[i].position.x);
+        instances[i].position[1] = to_snorm16(this->m_wall[i].position.y);
+        instances[i].scale = to_snorm16(this->m_wall[i].scale);
+    }
+
+    std::size_t angles_offset{ instances.size() * sizeof(WallInstance) };
+    std::size_t angles_size{ instances.size() * sizeof(WallAngle) };
+    const VertexFormat angle_format{ {
+        { 2, 1, GL_UNSIGNED_SHORT, GL_TRUE, 0 },
+        { 3, 1, GL_UNSIGNED_SHORT, GL_TRUE, angles_size },
+        { 4, 1, GL_UNSIGNED_SHORT, GL_TRUE, 2 * angles_size } },
+        sizeof(WallAngle) };
+
+    glBindBuffer(GL_ARRAY_BUFFER, this->m_wall_VBO);
+    glBufferData(GL_ARRAY_BUFFER, angles_offset + (3 * angles_size), nullptr,
+        GL_DYNAMIC_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, angles_offset, instances.data());
+
+    // Attribute 1 is the instance and 2 to 4 are the angles of the second,
+    // minute and hour hands. The hands advance to the next clock every
+    // three instances.
+    for (GLuint wall_VAO{ 0 }; wall_VAO < 2; wall_VAO++)
+    {
+        GLuint divisor{ wall_VAO == 0 ? 1 :
+            static_cast<GLuint>(hand_lengths.size()) };
+
+        glBindVertexArray(this->m_wall_VAOs[wall_VAO]);
+        wall_instance_format.apply(divisor);
+        if (wall_VAO == 1)
+            angle_format.apply(divisor, angles_offset);
+    }
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // The angles are written with the next frame
+    this->m_wall_second = std::numeric_limits<std::int64_t>::min();
+}
+
+std::size_t ClockRenderer::get_wall_size() const noexcept
+{
+    return this->m_wall.size();
+}
+
+int ClockRenderer::get_draw_calls() const noexcept
+{
+    return this->m_draw_calls;
+}
+
+// Fills the bound VBO and the EBO of the bound VAO with the full-screen quad
+// and the dial ring that fits the current rim and ticks
+void ClockRenderer::upload_dial_mesh() noexcept
+{
+    std::vector<DialVertex> vertices{ quad_vertices.begin(),
+        quad_vertices.end() };
+    std::vector<GLuint> indices{ quad_indices.begin(), quad_indices.end() };
+
+    GLfloat inner_radius{ std::min(this->m_line_length,
+        this->m_radius - dial_minute_tick_length) - dial_ring_margin };
+    GLfloat outer_radius{ this->m_radius + (0.5f * this->m_rim_thickness) +
+        dial_ring_margin };
+
+    append_annulus(inner_radius, outer_radius, dial_ring_segments, vertices,
+        indices);
+    this->m_dial_ring_index_count =
+        static_cast<GLsizei>(indices.size() - quad_indices.size());
+
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(DialVertex),
+        vertices.data(), GL_STATIC_DRAW);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint),
+        indices.data(), GL_STATIC_DRAW);
+}
+
+// Draws the dial ring of every clock on the wall, always with the signed
+// distance shader
+void ClockRenderer::draw_wall_dials() noexcept
+{
+    this->get_circle_program().activate_program();
+    glBindVertexArray(this->m_wall_VAOs[0]);
+    glDrawElementsInstanced(GL_TRIANGLES, this->m_dial_ring_index_count,
+        GL_UNSIGNED_INT, (void*)(quad_indices.size() * sizeof(GLuint)),
+        static_cast<GLsizei>(this->m_wall.size()));
+}
+
+void ClockRenderer::draw_dial_geometry() const noexcept
+{
+    glBindVertexArray(this->m_VAOs[0]);
+
+    if (this->m_dial_geometry == DialGeometry::annulus)
+        glDrawElements(GL_TRIANGLES, this->m_dial_ring_index_count,
+            GL_UNSIGNED_INT, (void*)(quad_indices.size() * sizeof(GLuint)));
+    else
+        glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+}
+
+// Clears to the theme background and draws the dial into the bound
+// framebuffer with the viewport already set and the theme state uploaded
+void ClockRenderer::draw_dial(const Theme& theme) noexcept
+{
+    glClearColor(theme.clear_color.x, theme.clear_color.y,
+        theme.clear_color.z, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    if (this->m_antialiasing == Antialiasing::analytic)
+        glEnable(GL_BLEND);
+
+    this->m_draw_calls++;
+    if (!this->m_wall.empty())
+    {
+        this->draw_wall_dials();
+        return;
+    }
+
+    if (this->m_dial_shader == DialShader::legacy)
+        this->m_legacy_circle_program->activate_program();
+    else
+        this->get_circle_program().activate_program();
+
+    this->draw_dial_geometry();
+}
+
+bool ClockRenderer::is_dial_cache_stale(const Theme& theme, int width,
+    int height) const noexcept
+{
+    return !this->m_dial || this->m_dial_stale ||
+        this->m_dial->get_width() != width ||
+        this->m_dial->get_height() != height ||
+        this->m_dial_clear_color != theme.clear_color ||
+        this->m_dial_circle_color != theme.circle_color;
+}
+
+void ClockRenderer::update_dial_cache(const Theme& theme, int width,
+    int height) noexcept
+{
+    GLint target_framebuffer{};
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &target_framebuffer);
+
+    GLsizei samples{ this->get_samples() };
+
+    if (!this->m_dial || this->m_dial->get_width() != width ||
+        this->m_dial->get_height() != height)
+    {
+        if (samples > 0)
+            this->m_dial_multisampled =
+                std::make_unique<Framebuffer>(width, height, samples);
+        this->m_dial = std::make_unique<Framebuffer>(width, height);
+    }
+
+    // With analytic antialiasing the dial is drawn right into the texture
+    if (samples > 0)
+    {
+        this->m_dial_multisampled->bind();
+        this->draw_dial(theme);
+        this->m_dial_multisampled->resolve_into(*this->m_dial);
+    }
+    else
+    {
+        this->m_dial->bind();
+        this->draw_dial(theme);
+    }
+
+    this->m_dial_clear_color = theme.clear_color;
+    this->m_dial_circle_color = theme.circle_color;
+    this->m_dial_stale = false;
+
+    glBindFramebuffer(GL_FRAMEBUFFER,
+        static_cast<GLuint>(target_framebuffer));
+}
+
+// Fits the square of the wall into the viewport and writes the hand angles
+// of every clock into the instance buffer in one go whenever the time shown
+// changes, once a second for a ticking wall. The UTC offsets of the clocks
+// only change on the second, so they are looked up then.
+void ClockRenderer::update_wall(const HandAngles& angles, int width,
+    int height) noexcept
+{
+    glm::mat4 model{ 1.0f };
+    if (width > height)
+        model[0][0] = static_cast<float>(height) / static_cast<float>(width);
+    else
+        model[1][1] = static_cast<float>(width) / static_cast<float>(height);
+
+    if (model != this->m_state.model)
+    {
+        this->m_state.model = model;
+        this->m_state_changed = true;
+        this->m_dial_stale = true;
+    }
+
+    float subsecond{ static_cast<float>(
+        angles.dial_seconds - std::floor(angles.dial_seconds)) };
+
+    if (angles.utc_seconds != this->m_wall_second)
+    {
+        for (std::size_t i{ 0 }; i < this->m_wall.size(); i++)
+            this->m_wall_offsets[i] =
+                this->m_wall[i].utc_offset_at(angles.utc_seconds);
+    }
+    else if (subsecond == this->m_wall_subsecond)
+        return;
+
+    std::size_t count{ this->m_wall.size() };
+    glBindBuffer(GL_ARRAY_BUFFER, this->m_wall_VBO);
+    auto* data{ static_cast<WallAngle*>(glMapBufferRange(GL_ARRAY_BUFFER,
+        static_cast<GLintptr>(count * sizeof(WallInstance)),
+        static_cast<GLsizeiptr>(3 * count * sizeof(WallAngle)),
+        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT)) };
+
+    if (data)
+    {
+        compute_wall_angles(angles.utc_seconds, subsecond,
+            this->m_wall_offsets.data(), count,
+            WallAngleArrays{ data, data + count, data + (2 * count) });
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+
+        this->m_wall_second = angles.utc_seconds;
+        this->m_wall_subsecond = subsecond;
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// Writes the colors of a new theme and changes to the dial into the uniform
+// buffer, everything but the per-frame range
+void ClockRenderer::update_shared_state(const Theme& theme) noexcept
+{
+    bool changed{ this->m_state_changed ||
+        this->m_state.circle_color != theme.circle_color };
+
+    for (std::size_t hand{ 0 }; hand < theme.hand_colors.size(); hand++)
+    {
+        glm::vec4 color{ theme.hand_colors[hand], 1.0f };
+        changed = changed || this->m_state.hand_colors[hand] != color;
+        this->m_state.hand_colors[hand] = color;
+    }
+    this->m_state.circle_color = theme.circle_color;
+
+    if (!changed)
+        return;
+
+    glBindBuffer(GL_UNIFORM_BUFFER, this->m_UBO);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, offsetof(ClockState, time_of_day),
+        &this->m_state);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    this->m_state_changed = false;
+}
+
+void ClockRenderer::draw(const Theme& theme, const HandAngles& angles,
+    int width, int height) noexcept
+{
+    this->m_draw_calls = 0;
+    if (width <= 0 || height <= 0)
+        return;
+
+    glViewport(0, 0, width, height);
+    if (!this->m_wall.empty())
+        this->update_wall(angles, width, height);
+    this->update_shared_state(theme);
+
+    ////////////////////////////////////////////////////////////////////////////
+
+    if (this->m_dial_cache_enabled)
+    {
+        if (this->is_dial_cache_stale(theme, width, height))
+            this->update_dial_cache(theme, width, height);
+
+        // Every pixel is overwritten, so there is nothing to clear or blend
+        glDisable(GL_BLEND);
+        this->m_dial_program.activate_program();
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, this->m_dial->get_texture_id());
+
+        glBindVertexArray(this->m_VAOs[0]);
+        glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+        this->m_draw_calls++;
+    }
+    else
+        this->draw_dial(theme);
+
+    ////////////////////////////////////////////////////////////////////////////
+
+    // All three hands in one draw. The vertex shader picks the length and
+    // color of each by gl_InstanceID and turns it from the time of day, which
+    // is the only state that has to be uploaded for it.
+    double whole_seconds{ std::floor(angles.dial_seconds) };
+    this->m_state.time_of_day = glm::vec2{
+        static_cast<float>(std::fmod(whole_seconds, 86400.0)),
+        static_cast<float>(angles.dial_seconds - whole_seconds)
+    };
+
+    glBindBuffer(GL_UNIFORM_BUFFER, this->m_UBO);
+    glBufferSubData(GL_UNIFORM_BUFFER, offsetof(ClockState, time_of_day),
+        sizeof(this->m_state.time_of_day), &this->m_state.time_of_day);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    if (this->m_antialiasing == Antialiasing::analytic)
+        glEnable(GL_BLEND);
+
+    // On a wall every clock draws its three hands in the same draw
+    GLsizei clocks{ this->m_wall.empty() ? 1 :
+        static_cast<GLsizei>(this->m_wall.size()) };
+
+    this->get_triangle_program().activate_program();
+    glBindVertexArray(this->m_wall.empty() ? this->m_VAOs[1] :
+        this->m_wall_VAOs[1]);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, 3,
+        clocks * static_cast<GLsizei>(hand_lengths.size()));
+    this->m_draw_calls++;
+}
+
+#endif
@@ -0,0 +1,222 @@
+#include "FrameScheduler.hpp"
+#include "SeqLock.hpp"
+#include "TimeService.hpp"
+#include "WakeupSource.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+#pragma once
+
+#ifndef CLOCK_TICKER_HPP
+#  define CLOCK_TICKER_HPP
+
+struct HandAngles
+{
+    float sec_degrees{};
+    float min_degrees{};
+    float hour_degrees{};
+
+    // The time of day in seconds that the angles show: whole seconds for a
+    // ticking clock, with the fraction for a sweeping one. The renderer
+    // turns the hands from this on the GPU.
+    double dial_seconds{};
+
+    // Incremented with every published snapshot
+    std::uint64_t epoch{};
+    std::int64_t utc_seconds{};
+
+    // Local time of day including the fraction of a second and the steady
+    // clock reading it was taken at, for sweeping hands to extrapolate from
+    double day_seconds{};
+    std::int64_t steady_nanoseconds{};
+};
+
+// Hand angles for a local time of day given in seconds. Every hand moves
+// continuously with the ones below it, so a whole number of seconds gives
+// the ticking clock and a fractional one the sweeping clock.
+HandAngles compute_hand_angles(double day_seconds) noexcept
+{
+    HandAngles angles{};
+
+    angles.sec_degrees =
+        static_cast<float>(std::fmod(day_seconds, 60.0) * 6.0);
+    angles.min_degrees =
+        static_cast<float>(std::fmod(day_seconds, 3600.0) / 10.0);
+    angles.hour_degrees =
+        static_cast<float>(std::fmod(day_seconds, 43200.0) / 120.0);
+    angles.dial_seconds = day_seconds;
+    angles.day_seconds = day_seconds;
+
+    return angles;
+}
+
+HandAngles compute_hand_angles(const LocalTime& local_time) noexcept
+{
+    double day_seconds{ (local_time.hour * 3600.0) +
+        (local_time.minute * 60.0) + local_time.second };
+
+    HandAngles angles{ compute_hand_angles(day_seconds) };
+    angles.utc_seconds = local_time.utc_seconds;
+    angles.day_seconds = day_seconds + local_time.subsecond;
+    angles.steady_nanoseconds =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+
+    return angles;
+}
+
+// Moves a published snapshot forward to the current instant with
+// sub-second precision. This costs one steady clock read and no timezone
+// work, so it is cheap enough to do for every frame at display refresh.
+HandAngles extrapolate_hand_angles(const HandAngles& snapshot) noexcept
+{
+    std::int64_t now{ std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count() };
+
+    double elapsed{
+        static_cast<double>(now - snapshot.steady_nanoseconds) / 1e9 };
+    double day_seconds{ std::fmod(snapshot.day_seconds + elapsed, 86400.0) };
+
+    HandAngles angles{ compute_hand_angles(day_seconds) };
+    angles.epoch = snapshot.epoch;
+    angles.steady_nanoseconds = now;
+
+    // UTC offsets are whole seconds, so the local fraction of a second is
+    // also the one of the UTC time
+    angles.utc_seconds = snapshot.utc_seconds +
+        static_cast<std::int64_t>(std::floor(snapshot.day_seconds -
+            std::floor(snapshot.day_seconds) + elapsed));
+
+    return angles;
+}
+
+// Owns time acquisition and the hand angle math on a thread of its own and
+// publishes the result through a SeqLock, so whoever renders only ever copies
+// a few words and never calls into libc for the time or waits on a lock.
+//
+// The thread is woken on the wall-clock grid for the given rate, by the
+// timerfd WakeupSource where there is one and by sleeping until the
+// FrameScheduler deadline otherwise. After every publish it calls the notify
+// function, which lets the render loop sleep until there is something new.
+class ClockTicker
+{
+    using notify_function = void (*)();
+
+    TimeService m_time_service{};
+    FrameScheduler m_scheduler;
+    WakeupSource m_wakeup{};
+    SeqLock<HandAngles> m_snapshot{};
+    std::uint64_t m_epoch{};
+    notify_function m_notify{};
+
+    std::thread m_thread{};
+    std::mutex m_stop_mutex{};
+    std::condition_variable m_stop_condition{};
+    bool m_stop_requested{ false };
+
+    void tick() noexcept;
+    void run() noexcept;
+
+public:
+    explicit ClockTicker(double = 1.0) noexcept;
+    ~ClockTicker() noexcept;
+
+    ClockTicker(const ClockTicker&) = delete;
+    ClockTicker& operator=(const ClockTicker&) = delete;
+
+    void start(notify_function, bool = true) noexcept;
+    void stop() noexcept;
+
+    HandAngles load() const noexcept;
+    const FrameStats& get_stats() const noexcept;
+};
+
+ClockTicker::ClockTicker(double target_hz) noexcept :
+    m_scheduler{ target_hz }
+{
+    // Publish once up front so the first frame has something to show
+    HandAngles angles{ compute_hand_angles(this->m_time_service.snapshot()) };
+    angles.epoch = ++this->m_epoch;
+    this->m_snapshot.store(angles);
+}
+
+ClockTicker::~ClockTicker() noexcept
+{
+    this->stop();
+}
+
+void ClockTicker::start(notify_function notify, bool use_timerfd) noexcept
+{
+    this->m_notify = notify;
+
+    if (use_timerfd &&
+        this->m_wakeup.start(this->m_scheduler.get_period(),
+            [this]() { this->tick(); }))
+        return;
+
+    this->m_thread = std::thread{ &ClockTicker::run, this };
+}
+
+// Stats are only safe to read once the ticker has been stopped
+void ClockTicker::stop() noexcept
+{
+    this->m_wakeup.stop();
+
+    if (this->m_thread.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock{ this->m_stop_mutex };
+            this->m_stop_requested = true;
+        }
+        this->m_stop_condition.notify_one();
+        this->m_thread.join();
+    }
+}
+
+void ClockTicker::run() noexcept
+{
+    std::unique_lock<std::mutex> lock{ this->m_stop_mutex };
+
+    while (!this->m_stop_condition.wait_until(lock,
+        this->m_scheduler.get_deadline(),
+        [this]() { return this->m_stop_requested; }))
+    {
+        this->tick();
+    }
+}
+
+void ClockTicker::tick() noexcept
+{
+    if (this->m_wakeup.take_clock_step())
+    {
+        this->m_time_service.invalidate();
+        this->m_scheduler.resync();
+    }
+
+    this->m_scheduler.begin_frame();
+
+    HandAngles angles{ compute_hand_angles(this->m_time_service.snapshot()) };
+    angles.epoch = ++this->m_epoch;
+    this->m_snapshot.store(angles);
+
+    if (this->m_notify)
+        this->m_notify();
+}
+
+HandAngles ClockTicker::load() const noexcept
+{
+    return this->m_snapshot.load();
+}
+
+const FrameStats& ClockTicker::get_stats() const noexcept
+{
+    return this->m_scheduler.get_stats();
+}
+
+#endif
@@ -0,0 +1,124 @@
+#include "TimeZone.hpp"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#pragma once
+
+#ifndef CLOCK_WALL_HPP
+#  define CLOCK_WALL_HPP
+
+// One clock on a wall of clocks. Positions and scales are in wall units: the
+// wall is the square from -1 to 1 fitted into the middle of the viewport, and
+// a clock of scale 1 is as big as the single clock filling the window.
+struct WallClock
+{
+    // A clock with a zone follows its daylight saving time; one without
+    // stays at the fixed offset
+    const TimeZone* zone{};
+    std::int32_t utc_offset{};
+
+    glm::vec2 position{};
+    float scale{ 1.0f };
+
+    std::int32_t utc_offset_at(std::int64_t) const noexcept;
+};
+
+std::int32_t WallClock::utc_offset_at(std::int64_t utc_seconds) const noexcept
+{
+    return this->zone ? this->zone->utc_offset_at(utc_seconds) :
+        this->utc_offset;
+}
+
+// Parses a UTC offset in hours with optional minutes, like 0, +1, -5 or
+// +5:30, into seconds
+bool parse_utc_offset(std::string_view value, std::int32_t& offset) noexcept
+{
+    std::string text{ value };
+    char* end{};
+
+    bool negative{ !text.empty() && text[0] == '-' };
+    long hours{ std::strtol(text.c_str(), &end, 10) };
+    if (end == text.c_str())
+        return false;
+
+    long minutes{};
+    if (*end == ':')
+    {
+        const char* begin{ end + 1 };
+        minutes = std::strtol(begin, &end, 10);
+        if (end == begin || minutes < 0 || minutes > 59)
+            return false;
+    }
+
+    if (*end != '\0' || hours < -14 || hours > 14)
+        return false;
+
+    long seconds{ (std::labs(hours) * 3600) + (minutes * 60) };
+    offset = static_cast<std::int32_t>(negative ? -seconds : seconds);
+    return true;
+}
+
+// Parses a comma separated list of zones of the tz database, like
+// Europe/Paris, and UTC offsets into clocks, not laid out yet
+bool parse_wall_clocks(std::string_view value,
+    std::vector<WallClock>& clocks) noexcept
+{
+    clocks.clear();
+
+    while (true)
+    {
+        std::size_t comma{ value.find(',') };
+        std::string_view name{ value.substr(0, comma) };
+
+        WallClock clock{};
+        if (!parse_utc_offset(name, clock.utc_offset))
+        {
+            clock.zone = zone_database.load(name);
+            if (!clock.zone)
+                return false;
+        }
+
+        clocks.push_back(clock);
+        if (comma == std::string_view::npos)
+            return true;
+
+        value.remove_prefix(comma + 1);
+    }
+}
+
+// Arranges the clocks row by row in the smallest square grid that holds them
+// all, each filling its cell
+void layout_wall_grid(std::vector<WallClock>& clocks) noexcept
+{
+    if (clocks.empty())
+        return;
+
+    std::size_t columns{ static_cast<std::size_t>(
+        std::ceil(std::sqrt(static_cast<double>(clocks.size())))) };
+    std::size_t rows{ (clocks.size() + columns - 1) / columns };
+    float cell{ 2.0f / static_cast<float>(std::max(columns, rows)) };
+
+    // Centers the grid when it has fewer rows than columns
+    float top{ 0.5f * cell * static_cast<float>(rows) };
+
+    for (std::size_t i{ 0 }; i < clocks.size(); i++)
+    {
+        float column{ static_cast<float>(i % columns) };
+        float row{ static_cast<float>(i / columns) };
+
+        clocks[i].position = glm::vec2{ -1.0f + (cell * (column + 0.5f)),
+            top - (cell * (row + 0.5f)) };
+        clocks[i].scale = 0.5f * cell;
+    }
+}
+
+#endif
@@ -0,0 +1,184 @@
+#include <chrono>
+#include <cstdint>
+#include <ratio>
+#include <thread>
+
+#pragma once
+
+#ifndef FRAME_SCHEDULER_HPP
+#  define FRAME_SCHEDULER_HPP
+
+struct FrameStats
+{
+    std::uint64_t frames{};
+    std::uint64_t missed_deadlines{};
+
+    // Lateness is how far after its deadline a frame actually started
+    std::chrono::nanoseconds last_lateness{};
+    std::chrono::nanoseconds max_lateness{};
+    std::chrono::nanoseconds total_lateness{};
+
+    std::chrono::nanoseconds mean_lateness() const noexcept;
+};
+
+std::chrono::nanoseconds FrameStats::mean_lateness() const noexcept
+{
+    if (this->frames == 0)
+        return std::chrono::nanoseconds{ 0 };
+
+    return this->total_lateness / static_cast<std::int64_t>(this->frames);
+}
+
+// Schedules frames on absolute deadlines that sit on the wall-clock grid for
+// the target rate, so a 1 Hz clock always starts its frame right after the
+// second changes and a late frame never pushes the following ones back.
+class FrameScheduler
+{
+public:
+    using steady_clock = std::chrono::steady_clock;
+    using system_clock = std::chrono::system_clock;
+
+private:
+    // Wakeups that arrive on the wall-clock grid can land a hair before the
+    // deadline projected onto the steady clock, and still count as on time
+    static constexpr std::chrono::microseconds m_tolerance{ 500 };
+
+    std::chrono::nanoseconds m_period{};
+    std::int64_t m_index{};
+    steady_clock::time_point m_deadline{};
+    FrameStats m_stats{};
+
+    void schedule_after(std::int64_t) noexcept;
+
+public:
+    explicit FrameScheduler(double = 1.0) noexcept;
+
+    void set_target_rate(double) noexcept;
+    double get_target_rate() const noexcept;
+    std::chrono::nanoseconds get_period() const noexcept;
+
+    void resync() noexcept;
+
+    steady_clock::time_point get_deadline() const noexcept;
+    steady_clock::duration time_until_deadline() const noexcept;
+    bool deadline_reached() const noexcept;
+
+    void wait_for_deadline() const noexcept;
+    void begin_frame() noexcept;
+
+    const FrameStats& get_stats() const noexcept;
+};
+
+FrameScheduler::FrameScheduler(double target_hz) noexcept
+{
+    this->set_target_rate(target_hz);
+}
+
+void FrameScheduler::set_target_rate(double target_hz) noexcept
+{
+    if (target_hz <= 0.0)
+        target_hz = 1.0;
+
+    this->m_period = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::duration<double>(1.0 / target_hz));
+
+    auto since_epoch{ system_clock::now().time_since_epoch() };
+    this->schedule_after(since_epoch / this->m_period);
+}
+
+double FrameScheduler::get_target_rate() const noexcept
+{
+    return 1.0 / std::chrono::duration<double>(this->m_period).count();
+}
+
+std::chrono::nanoseconds FrameScheduler::get_period() const noexcept
+{
+    return this->m_period;
+}
+
+// Projects the deadline onto the steady clock again, for when the system
+// clock was stepped and the old projection no longer matches the wall clock
+void FrameScheduler::resync() noexcept
+{
+    auto since_epoch{ system_clock::now().time_since_epoch() };
+    this->schedule_after(since_epoch / this->m_period);
+}
+
+// Targets the grid slot after `index`, measured on the system clock so that
+// NTP slewing between the two clocks cannot accumulate into drift
+void FrameScheduler::schedule_after(std::int64_t index) noexcept
+{
+    auto steady_now{ steady_clock::now() };
+    auto since_epoch{ std::chrono::duration_cast<std::chrono::nanoseconds>(
+        system_clock::now().time_since_epoch()) };
+
+    // A clock stepped backwards would otherwise leave us waiting for a slot
+    // that is far in the future, so fall back onto the current grid
+    if (((this->m_period * (index + 1)) - since_epoch) > this->m_period)
+        index = (since_epoch / this->m_period);
+
+    this->m_index = index + 1;
+    this->m_deadline = steady_now +
+        ((this->m_period * this->m_index) - since_epoch);
+}
+
+FrameScheduler::steady_clock::time_point FrameScheduler::get_deadline() const
+noexcept
+{
+    return this->m_deadline;
+}
+
+FrameScheduler::steady_clock::duration FrameScheduler::time_until_deadline()
+const noexcept
+{
+    auto remaining{ this->m_deadline - steady_clock::now() };
+    return remaining > this->m_tolerance ?
+        remaining : steady_clock::duration{ 0 };
+}
+
+bool FrameScheduler::deadline_reached() const noexcept
+{
+    return steady_clock::now() + this->m_tolerance >= this->m_deadline;
+}
+
+void FrameScheduler::wait_for_deadline() const noexcept
+{
+    std::this_thread::sleep_until(this->m_deadline);
+}
+
+// Records how late the frame for the current deadline started and moves the
+// deadline forward; slots that already went by are counted as missed and
+// skipped instead of being rendered back to back. Does nothing before the
+// deadline, so it is safe to call on every pass of an event loop.
+void FrameScheduler::begin_frame() noexcept
+{
+    if (!this->deadline_reached())
+        return;
+
+    auto lateness{ std::chrono::duration_cast<std::chrono::nanoseconds>(
+        steady_clock::now() - this->m_deadline) };
+    if (lateness.count() < 0)
+        lateness = std::chrono::nanoseconds{ 0 };
+
+    this->m_stats.frames++;
+    this->m_stats.last_lateness = lateness;
+    this->m_stats.total_lateness += lateness;
+    if (lateness > this->m_stats.max_lateness)
+        this->m_stats.max_lateness = lateness;
+
+    auto since_epoch{ system_clock::now().time_since_epoch() };
+    std::int64_t current{ since_epoch / this->m_period };
+
+    if (current > this->m_index)
+        this->m_stats.missed_deadlines +=
+            static_cast<std::uint64_t>(current - this->m_index);
+
+    this->schedule_after(current > this->m_index ? current : this->m_index);
+}
+
+const FrameStats& FrameScheduler::get_stats() const noexcept
+{
+    return this->m_stats;
+}
+
+#endif
@@ -0,0 +1,178 @@
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#pragma once
+
+#ifndef FRAMEBUFFER_HPP
+#  define FRAMEBUFFER_HPP
+
+// An offscreen RGBA8 render target. With samples > 0 it is multisampled and
+// has to be resolved into a single-sampled Framebuffer before reading it.
+// A single-sampled one is backed by a texture, so it can also be sampled.
+class Framebuffer
+{
+    GLuint m_framebuffer_id{};
+    GLuint m_color_id{};
+    GLsizei m_width{};
+    GLsizei m_height{};
+    GLsizei m_samples{};
+
+public:
+    Framebuffer(GLsizei, GLsizei, GLsizei = 0) noexcept;
+    ~Framebuffer() noexcept;
+
+    Framebuffer(const Framebuffer&) = delete;
+    Framebuffer& operator=(const Framebuffer&) = delete;
+
+    bool is_complete() const noexcept;
+
+    void bind() const noexcept;
+    void resolve_into(const Framebuffer&) const noexcept;
+    void read_pixels(std::vector<std::uint8_t>&) const noexcept;
+
+    GLuint get_framebuffer_id() const noexcept;
+    GLuint get_texture_id() const noexcept;
+    GLsizei get_width() const noexcept;
+    GLsizei get_height() const noexcept;
+};
+
+Framebuffer::Framebuffer(GLsizei width, GLsizei height, GLsizei samples)
+noexcept : m_width{ width }, m_height{ height }, m_samples{ samples }
+{
+    glGenFramebuffers(1, &this->m_framebuffer_id);
+    glBindFramebuffer(GL_FRAMEBUFFER, this->m_framebuffer_id);
+
+    if (samples > 0)
+    {
+        glGenRenderbuffers(1, &this->m_color_id);
+        glBindRenderbuffer(GL_RENDERBUFFER, this->m_color_id);
+        glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_RGBA8,
+            width, height);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+            GL_RENDERBUFFER, this->m_color_id);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    }
+    else
+    {
+        glGenTextures(1, &this->m_color_id);
+        glBindTexture(GL_TEXTURE_2D, this->m_color_id);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA,
+            GL_UNSIGNED_BYTE, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+            GL_TEXTURE_2D, this->m_color_id, 0);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+
+    if (!this->is_complete())
+        std::cerr << "Error: Framebuffer is incomplete\n";
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+Framebuffer::~Framebuffer() noexcept
+{
+    glDeleteFramebuffers(1, &this->m_framebuffer_id);
+
+    if (this->m_samples > 0)
+        glDeleteRenderbuffers(1, &this->m_color_id);
+    else
+        glDeleteTextures(1, &this->m_color_id);
+}
+
+bool Framebuffer::is_complete() const noexcept
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, this->m_framebuffer_id);
+    return glCheckFramebufferStatus(GL_FRAMEBUFFER) ==
+        GL_FRAMEBUFFER_COMPLETE;
+}
+
+void Framebuffer::bind() const noexcept
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, this->m_framebuffer_id);
+}
+
+void Framebuffer::resolve_into(const Framebuffer& target) const noexcept
+{
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, this->m_framebuffer_id);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, target.m_framebuffer_id);
+    glBlitFramebuffer(0, 0, this->m_width, this->m_height,
+        0, 0, target.m_width, target.m_height,
+        GL_COLOR_BUFFER_BIT, GL_NEAREST);
+}
+
+// Reads the whole framebuffer as tightly packed RGBA8, bottom row first
+void Framebuffer::read_pixels(std::vector<std::uint8_t>& pixels) const
+noexcept
+{
+    pixels.resize(static_cast<std::size_t>(this->m_width) * this->m_height * 4);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, this->m_framebuffer_id);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, this->m_width, this->m_height, GL_RGBA,
+        GL_UNSIGNED_BYTE, pixels.data());
+}
+
+GLuint Framebuffer::get_framebuffer_id() const noexcept
+{
+    return this->m_framebuffer_id;
+}
+
+// The color texture of a single-sampled framebuffer, 0 for a multisampled one
+GLuint Framebuffer::get_texture_id() const noexcept
+{
+    return this->m_samples > 0 ? 0 : this->m_color_id;
+}
+
+GLsizei Framebuffer::get_width() const noexcept
+{
+    return this->m_width;
+}
+
+GLsizei Framebuffer::get_height() const noexcept
+{
+    return this->m_height;
+}
+
+// Writes RGBA8 pixels as read back from GL (bottom row first) to a binary
+// PPM, dropping alpha and flipping the rows into top-down order
+bool write_ppm(const std::string& path, GLsizei width, GLsizei height,
+    const std::vector<std::uint8_t>& pixels) noexcept
+{
+    std::ofstream file{ path, std::ios::out | std::ios::binary };
+    if (!file)
+    {
+        std::cerr << "Error: Unable to open '" << path << "' for writing\n";
+        return false;
+    }
+
+    file << "P6\n" << width << ' ' << height << "\n255\n";
+
+    std::vector<char> row(static_cast<std::size_t>(width) * 3);
+    for (GLsizei y{ height - 1 }; y >= 0; y--)
+    {
+        const std::uint8_t* source{ pixels.data() +
+            (static_cast<std::size_t>(y) * width * 4) };
+
+        for (GLsizei x{ 0 }; x < width; x++)
+        {
+            row[(x * 3) + 0] = static_cast<char>(source[(x * 4) + 0]);
+            row[(x * 3) + 1] = static_cast<char>(source[(x * 4) + 1]);
+            row[(x * 3) + 2] = static_cast<char>(source[(x * 4) + 2]);
+        }
+
+        file.write(row.data(), static_cast<std::streamsize>(row.size()));
+    }
+
+    return static_cast<bool>(file);
+}
+
+#endif
@@ -0,0 +1,211 @@
+#include <glad/glad.h>
+
+#include <cstring>
+#include <iostream>
+
+#ifdef __linux__
+#  include <EGL/egl.h>
+#  include <EGL/eglext.h>
+#endif
+
+#pragma once
+
+#ifndef HEADLESS_CONTEXT_HPP
+#  define HEADLESS_CONTEXT_HPP
+
+// An OpenGL 3.3 core context without any window, for rendering on machines
+// with no display (e.g. Mesa llvmpipe on a server).
+//
+// Uses EGL on the surfaceless platform when the driver offers it and the
+// default display otherwise. The context is made current without a surface
+// where EGL_KHR_surfaceless_context allows it and with a 1x1 pbuffer
+// otherwise; all real rendering goes to a Framebuffer anyway.
+class HeadlessContext
+{
+#ifdef __linux__
+    EGLDisplay m_display{ EGL_NO_DISPLAY };
+    EGLContext m_context{ EGL_NO_CONTEXT };
+    EGLSurface m_surface{ EGL_NO_SURFACE };
+#endif
+    bool m_current{ false };
+
+public:
+    HeadlessContext() noexcept;
+    ~HeadlessContext() noexcept;
+
+    HeadlessContext(const HeadlessContext&) = delete;
+    HeadlessContext& operator=(const HeadlessContext&) = delete;
+
+    bool is_current() const noexcept;
+    GLADloadproc get_loader() const noexcept;
+};
+
+#ifdef __linux__
+
+bool has_egl_extension(const char* extensions, const char* name) noexcept
+{
+    if (!extensions)
+        return false;
+
+    std::size_t length{ std::strlen(name) };
+    for (const char* found{ std::strstr(extensions, name) }; found;
+        found = std::strstr(found + length, name))
+    {
+        bool starts{ found == extensions || found[-1] == ' ' };
+        bool ends{ found[length] == ' ' || found[length] == '\0' };
+        if (starts && ends)
+            return true;
+    }
+
+    return false;
+}
+
+HeadlessContext::HeadlessContext() noexcept
+{
+    const char* client_extensions{
+        eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS) };
+
+    if (has_egl_extension(client_extensions, "EGL_MESA_platform_surfaceless"))
+    {
+        auto get_platform_display{
+            reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+                eglGetProcAddress("eglGetPlatformDisplayEXT")) };
+
+        if (get_platform_display)
+            this->m_display = get_platform_display(
+                EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    }
+
+    if (this->m_display == EGL_NO_DISPLAY)
+        this->m_display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+    if (this->m_display == EGL_NO_DISPLAY ||
+        !eglInitialize(this->m_display, nullptr, nullptr))
+    {
+        std::cerr << "Error: Unable to initialize EGL display\n";
+        return;
+    }
+
+    if (!eglBindAPI(EGL_OPENGL_API))
+    {
+        std::cerr << "Error: EGL does not support desktop OpenGL\n";
+        return;
+    }
+
+    bool surfaceless{ has_egl_extension(
+        eglQueryString(this->m_display, EGL_EXTENSIONS),
+        "EGL_KHR_surfaceless_context") };
+
+    const EGLint config_attributes[]{
+        EGL_SURFACE_TYPE, surfaceless ? 0 : EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_RED_SIZE, 8,
+        EGL_GREEN_SIZE, 8,
+        EGL_BLUE_SIZE, 8,
+        EGL_ALPHA_SIZE, 8,
+        EGL_NONE
+    };
+
+    EGLConfig config{};
+    EGLint config_count{};
+    if (!eglChooseConfig(this->m_display, config_attributes, &config, 1,
+        &config_count) || config_count == 0)
+    {
+        std::cerr << "Error: No suitable EGL config\n";
+        return;
+    }
+
+    const EGLint context_attributes[]{
+        EGL_CONTEXT_MAJOR_VERSION, 3,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+
+    this->m_context = eglCreateContext(this->m_display, config,
+        EGL_NO_CONTEXT, context_attributes);
+    if (this->m_context == EGL_NO_CONTEXT)
+    {
+        std::cerr << "Error: Unable to create an OpenGL 3.3 EGL context\n";
+        return;
+    }
+
+    if (!surfaceless)
+    {
+        const EGLint pbuffer_attributes[]{
+            EGL_WIDTH, 1,
+            EGL_HEIGHT, 1,
+            EGL_NONE
+        };
+
+        this->m_surface = eglCreatePbufferSurface(this->m_display, config,
+            pbuffer_attributes);
+        if (this->m_surface == EGL_NO_SURFACE)
+        {
+            std::cerr << "Error: Unable to create an EGL pbuffer\n";
+            return;
+        }
+    }
+
+    if (!eglMakeCurrent(this->m_display, this->m_surface, this->m_surface,
+        this->m_context))
+    {
+        std::cerr << "Error: Unable to make the EGL context current\n";
+        return;
+    }
+
+    if (!gladLoadGLLoader((GLADloadproc)eglGetProcAddress))
+    {
+        std::cerr << "Error: Unable to initiailze glad\n";
+        return;
+    }
+
+    this->m_current = true;
+}
+
+HeadlessContext::~HeadlessContext() noexcept
+{
+    if (this->m_display == EGL_NO_DISPLAY)
+        return;
+
+    eglMakeCurrent(this->m_display, EGL_NO_SURFACE, EGL_NO_SURFACE,
+        EGL_NO_CONTEXT);
+
+    if (this->m_surface != EGL_NO_SURFACE)
+        eglDestroySurface(this->m_display, this->m_surface);
+    if (this->m_context != EGL_NO_CONTEXT)
+        eglDestroyContext(this->m_display, this->m_context);
+
+    eglTerminate(this->m_display);
+}
+
+#else
+
+HeadlessContext::HeadlessContext() noexcept
+{
+    std::cerr << "Error: Headless rendering needs EGL, which is only "
+                 "supported on Linux\n";
+}
+
+HeadlessContext::~HeadlessContext() noexcept
+{
+}
+
+#endif
+
+bool HeadlessContext::is_current() const noexcept
+{
+    return this->m_current;
+}
+
+// Resolves GL entry points glad was not generated with, e.g. extensions
+GLADloadproc HeadlessContext::get_loader() const noexcept
+{
+#ifdef __linux__
+    return reinterpret_cast<GLADloadproc>(eglGetProcAddress);
+#else
+    return nullptr;
+#endif
+}
+
+#endif
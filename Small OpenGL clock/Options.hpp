@@ -0,0 +1,337 @@
+#include "ClockRenderer.hpp"
+#include "PixelStreamer.hpp"
+#include "Theme.hpp"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#pragma once
+
+#ifndef OPTIONS_HPP
+#  define OPTIONS_HPP
+
+enum class SweepMode
+{
+    // Hands jump once per tick
+    off,
+    // Hands sweep continuously, rendered at display refresh with vsync
+    on,
+    // Sweep while the window is visible, tick while it is iconified or
+    // hidden
+    adaptive
+};
+
+struct Options
+{
+    // A target rate of 0 means "use the refresh rate of the display"
+    double target_rate{ 1.0 };
+    bool print_stats{ false };
+    bool use_timerfd{ true };
+    SweepMode sweep_mode{ SweepMode::off };
+    std::size_t theme{ 0 };
+    bool dial_cache{ true };
+    int hour_ticks{ 12 };
+    int minute_ticks{ 0 };
+    Antialiasing antialiasing{ Antialiasing::msaa };
+
+    // A wall of clocks in place of the single one, laid out in a grid
+    std::vector<WallClock> wall{};
+
+    // Where linked shader programs are kept between runs
+    bool shader_cache{ true };
+    std::string shader_cache_path{ ".shader-cache" };
+
+    // Shaders and palette come from this pack when it exists; with
+    // pack_assets it is built from the loose files instead
+    std::string asset_pack_path{ "clock.pack" };
+    bool pack_assets{ false };
+
+    // Rebuild the dial and hand shaders whenever their files change
+    bool watch_shaders{ false };
+
+    // Offscreen rendering of a single frame, written to output_path. A
+    // negative time of day means "now".
+    bool headless{ false };
+    double time_of_day{ -1.0 };
+    int width{ 400 };
+    int height{ 400 };
+    std::string output_path{ "clock.ppm" };
+
+    // Continuous stream of rendered frames, from the window or headless. A
+    // frame count of 0 streams until the process is stopped.
+    StreamFormat stream_format{ StreamFormat::none };
+    int stream_fd{ 1 };
+    long long frames{ 0 };
+
+    // Name of a benchmark to run instead of opening the clock window
+    std::string benchmark{};
+};
+
+void print_usage(std::string_view program) noexcept
+{
+    std::cerr << "Usage: " << program << " [options]\n"
+        "  --rate=<hz|display>  Frames per second, default 1\n"
+        "  --stats              Print frame timing statistics on exit\n"
+        "  --no-timerfd         Wait with timeouts instead of a timerfd\n"
+        "  --sweep[=adaptive]   Sweep the hands smoothly at display refresh\n"
+        "  --theme=<name>       Start with the dark or light theme\n"
+        "  --no-dial-cache      Draw the dial every frame instead of once\n"
+        "  --ticks=<h>[,<m>]    Hour and minute ticks on the dial, default 12\n"
+        "  --aa=<msaa|analytic> Antialias with 4x MSAA or in the shaders\n"
+        "  --wall=<zone>,...    A wall of clocks in zones like Asia/Tokyo or\n"
+        "                       at UTC offsets like -5 and +5:30\n"
+        "  --shader-cache=<dir> Directory for linked shaders (.shader-cache)\n"
+        "  --no-shader-cache    Compile the shaders from source every start\n"
+        "  --assets=<path>      Asset pack to load, default clock.pack\n"
+        "  --pack-assets        Build the asset pack from the .glsl files\n"
+        "  --watch-shaders      Reload the dial and hand shaders on changes\n"
+        "  --bench=<name>       Run a benchmark and exit (time, dial,\n"
+        "                       uniform, dial-shader, overdraw, aa, startup,\n"
+        "                       wall, zones, angles)\n"
+        "\n"
+        "  --headless           Render one frame offscreen to a PPM file\n"
+        "  --time=<hh:mm:ss>    Time of day to render, default now\n"
+        "  --size=<w>x<h>       Size of the offscreen frame, default 400x400\n"
+        "  --output=<path>      Where to write the frame, default clock.ppm\n"
+        "\n"
+        "  --stream=<rgba|y4m>  Stream every frame as raw RGBA or Y4M\n"
+        "  --stream-fd=<fd>     Descriptor to stream to, default 1 (stdout)\n"
+        "  --frames=<count>     Stop a headless stream after this many frames\n";
+}
+
+// Parses hh:mm:ss with an optional fraction of a second into seconds of day
+bool parse_time_of_day(std::string_view value, double& seconds) noexcept
+{
+    std::string text{ value };
+    int hours{}, minutes{};
+    double rest{};
+    char* end{};
+
+    hours = static_cast<int>(std::strtol(text.c_str(), &end, 10));
+    if (*end != ':')
+        return false;
+    minutes = static_cast<int>(std::strtol(end + 1, &end, 10));
+    if (*end != ':')
+        return false;
+    rest = std::strtod(end + 1, &end);
+    if (*end != '\0')
+        return false;
+
+    if (hours < 0 || hours > 23 || minutes < 0 || minutes > 59 ||
+        rest < 0.0 || rest >= 60.0)
+        return false;
+
+    seconds = (hours * 3600.0) + (minutes * 60.0) + rest;
+    return true;
+}
+
+bool parse_options(int argc, char* argv[], Options& options) noexcept
+{
+    for (int i{ 1 }; i < argc; i++)
+    {
+        std::string_view arg{ argv[i] };
+
+        if (arg.substr(0, 7) == "--rate=")
+        {
+            std::string_view value{ arg.substr(7) };
+            if (value == "display")
+            {
+                options.target_rate = 0.0;
+                continue;
+            }
+
+            char* end{};
+            options.target_rate = std::strtod(value.data(), &end);
+            if (end == value.data() || *end != '\0' ||
+                !std::isfinite(options.target_rate) ||
+                options.target_rate <= 0.0)
+            {
+                std::cerr << "Error: Invalid rate '" << value << "'\n";
+                return false;
+            }
+        }
+        else if (arg == "--stats")
+        {
+            options.print_stats = true;
+        }
+        else if (arg == "--no-timerfd")
+        {
+            options.use_timerfd = false;
+        }
+        else if (arg == "--sweep")
+        {
+            options.sweep_mode = SweepMode::on;
+        }
+        else if (arg == "--sweep=adaptive")
+        {
+            options.sweep_mode = SweepMode::adaptive;
+        }
+        else if (arg.substr(0, 8) == "--theme=")
+        {
+            std::string_view value{ arg.substr(8) };
+            bool found{ false };
+
+            for (std::size_t theme{ 0 }; theme < themes.size(); theme++)
+            {
+                if (themes[theme].name == value)
+                {
+                    options.theme = theme;
+                    found = true;
+                }
+            }
+
+            if (!found)
+            {
+                std::cerr << "Error: Unknown theme '" << value << "'\n";
+                return false;
+            }
+        }
+        else if (arg == "--no-dial-cache")
+        {
+            options.dial_cache = false;
+        }
+        else if (arg.substr(0, 8) == "--ticks=")
+        {
+            std::string value{ arg.substr(8) };
+            char* end{};
+
+            options.hour_ticks = static_cast<int>(
+                std::strtol(value.c_str(), &end, 10));
+            options.minute_ticks = 0;
+            if (*end == ',')
+                options.minute_ticks = static_cast<int>(
+                    std::strtol(end + 1, &end, 10));
+
+            if (*end != '\0' || options.hour_ticks < 0 ||
+                options.hour_ticks > 720 || options.minute_ticks < 0 ||
+                options.minute_ticks > 720)
+            {
+                std::cerr << "Error: Invalid ticks '" << value << "'\n";
+                return false;
+            }
+        }
+        else if (arg == "--aa=msaa")
+        {
+            options.antialiasing = Antialiasing::msaa;
+        }
+        else if (arg == "--aa=analytic")
+        {
+            options.antialiasing = Antialiasing::analytic;
+        }
+        else if (arg.substr(0, 7) == "--wall=")
+        {
+            if (!parse_wall_clocks(arg.substr(7), options.wall))
+            {
+                std::cerr << "Error: Invalid wall '" << arg.substr(7)
+                          << "'\n";
+                return false;
+            }
+
+            layout_wall_grid(options.wall);
+        }
+        else if (arg.substr(0, 15) == "--shader-cache=")
+        {
+            options.shader_cache_path = arg.substr(15);
+        }
+        else if (arg == "--no-shader-cache")
+        {
+            options.shader_cache = false;
+        }
+        else if (arg.substr(0, 9) == "--assets=")
+        {
+            options.asset_pack_path = arg.substr(9);
+        }
+        else if (arg == "--pack-assets")
+        {
+            options.pack_assets = true;
+        }
+        else if (arg == "--watch-shaders")
+        {
+            options.watch_shaders = true;
+        }
+        else if (arg.substr(0, 8) == "--bench=")
+        {
+            options.benchmark = arg.substr(8);
+        }
+        else if (arg == "--headless")
+        {
+            options.headless = true;
+        }
+        else if (arg.substr(0, 7) == "--time=")
+        {
+            if (!parse_time_of_day(arg.substr(7), options.time_of_day))
+            {
+                std::cerr << "Error: Invalid time '" << arg.substr(7) << "'\n";
+                return false;
+            }
+        }
+        else if (arg.substr(0, 7) == "--size=")
+        {
+            std::string value{ arg.substr(7) };
+            char* end{};
+
+            options.width = static_cast<int>(
+                std::strtol(value.c_str(), &end, 10));
+            if (*end == 'x')
+                options.height = static_cast<int>(
+                    std::strtol(end + 1, &end, 10));
+
+            if (*end != '\0' || options.width <= 0 || options.height <= 0)
+            {
+                std::cerr << "Error: Invalid size '" << value << "'\n";
+                return false;
+            }
+        }
+        else if (arg.substr(0, 9) == "--output=")
+        {
+            options.output_path = arg.substr(9);
+        }
+        else if (arg == "--stream=rgba")
+        {
+            options.stream_format = StreamFormat::rgba;
+        }
+        else if (arg == "--stream=y4m")
+        {
+            options.stream_format = StreamFormat::y4m;
+        }
+        else if (arg.substr(0, 12) == "--stream-fd=")
+        {
+            const char* value{ arg.substr(12).data() };
+            char* end{};
+            options.stream_fd = static_cast<int>(std::strtol(value, &end, 10));
+            if (end == value || *end != '\0' || options.stream_fd < 0)
+            {
+                std::cerr << "Error: Invalid descriptor '" << arg.substr(12)
+                          << "'\n";
+                return false;
+            }
+        }
+        else if (arg.substr(0, 9) == "--frames=")
+        {
+            const char* value{ arg.substr(9).data() };
+            char* end{};
+            options.frames = std::strtoll(value, &end, 10);
+            if (end == value || *end != '\0' || options.frames < 0)
+            {
+                std::cerr << "Error: Invalid frame count '" << arg.substr(9)
+                          << "'\n";
+                return false;
+            }
+        }
+        else
+        {
+            std::cerr << "Error: Unknown option '" << arg << "'\n";
+            print_usage(argv[0]);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+#endif
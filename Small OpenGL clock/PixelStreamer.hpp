@@ -0,0 +1,381 @@
+#include "Framebuffer.hpp"
+
+#include <glad/glad.h>
+
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#  include <io.h>
+#else
+#  include <csignal>
+#  include <unistd.h>
+#endif
+
+#pragma once
+
+#ifndef PIXEL_STREAMER_HPP
+#  define PIXEL_STREAMER_HPP
+
+enum class StreamFormat
+{
+    none,
+    // Tightly packed top-down RGBA8 frames, one after the other
+    rgba,
+    // YUV4MPEG2 with full-resolution 4:4:4 chroma
+    y4m
+};
+
+// Streams rendered frames to a file descriptor without stalling rendering.
+//
+// Every captured frame is resolved into a single-sampled framebuffer and read
+// into one of a ring of pixel buffer objects, followed by a fence. The copy to
+// system memory happens only once a fence has signalled, usually a frame or
+// two later, so reading frame N overlaps with rendering frame N+1. Converting
+// and writing the frames happens on a writer thread, so a slow consumer only
+// blocks rendering once several frames are queued up.
+class PixelStreamer
+{
+    static constexpr std::size_t m_slot_count{ 3 };
+    static constexpr std::size_t m_max_queued_frames{ 8 };
+
+    struct Slot
+    {
+        GLuint buffer_id{};
+        GLsync fence{};
+        bool pending{ false };
+    };
+
+    std::array<Slot, m_slot_count> m_slots{};
+    std::size_t m_next{};
+    std::size_t m_oldest{};
+
+    Framebuffer m_resolved;
+    GLsizei m_width{};
+    GLsizei m_height{};
+    std::size_t m_frame_size{};
+
+    StreamFormat m_format{};
+    int m_fd{};
+    double m_rate{};
+
+    std::thread m_writer{};
+    std::mutex m_queue_mutex{};
+    std::condition_variable m_queue_condition{};
+    std::deque<std::vector<std::uint8_t>> m_queue{};
+    std::vector<std::vector<std::uint8_t>> m_free_frames{};
+    bool m_finished{ false };
+    bool m_failed{ false };
+
+    bool retire_oldest(bool) noexcept;
+    void run_writer() noexcept;
+    bool write_all(const void*, std::size_t) noexcept;
+    void convert(const std::vector<std::uint8_t>&,
+        std::vector<std::uint8_t>&) const noexcept;
+
+public:
+    PixelStreamer(GLsizei, GLsizei, StreamFormat, int, double) noexcept;
+    ~PixelStreamer() noexcept;
+
+    PixelStreamer(const PixelStreamer&) = delete;
+    PixelStreamer& operator=(const PixelStreamer&) = delete;
+
+    void capture(GLuint) noexcept;
+    void finish() noexcept;
+
+    bool has_failed() noexcept;
+};
+
+PixelStreamer::PixelStreamer(GLsizei width, GLsizei height,
+    StreamFormat format, int fd, double rate) noexcept :
+    m_resolved{ width, height },
+    m_width{ width },
+    m_height{ height },
+    m_frame_size{ static_cast<std::size_t>(width) * height * 4 },
+    m_format{ format },
+    m_fd{ fd },
+    m_rate{ rate }
+{
+#ifndef _WIN32
+    // A consumer going away should end the stream, not the process
+    std::signal(SIGPIPE, SIG_IGN);
+#endif
+
+    for (Slot& slot : this->m_slots)
+    {
+        glGenBuffers(1, &slot.buffer_id);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer_id);
+        glBufferData(GL_PIXEL_PACK_BUFFER,
+            static_cast<GLsizeiptr>(this->m_frame_size), nullptr,
+            GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    this->m_writer = std::thread{ &PixelStreamer::run_writer, this };
+}
+
+PixelStreamer::~PixelStreamer() noexcept
+{
+    this->finish();
+
+    for (Slot& slot : this->m_slots)
+    {
+        if (slot.fence)
+            glDeleteSync(slot.fence);
+        glDeleteBuffers(1, &slot.buffer_id);
+    }
+}
+
+// Queues an asynchronous readback of the given framebuffer, which may be
+// multisampled (0 is the window's back buffer)
+void PixelStreamer::capture(GLuint source_framebuffer) noexcept
+{
+    // The ring is full, so the oldest frame has to come out first
+    if (this->m_slots[this->m_next].pending)
+        this->retire_oldest(true);
+
+    Slot& slot{ this->m_slots[this->m_next] };
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, source_framebuffer);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER,
+        this->m_resolved.get_framebuffer_id());
+    glBlitFramebuffer(0, 0, this->m_width, this->m_height,
+        0, 0, this->m_width, this->m_height,
+        GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER,
+        this->m_resolved.get_framebuffer_id());
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer_id);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, this->m_width, this->m_height, GL_RGBA,
+        GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, source_framebuffer);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, source_framebuffer);
+
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot.pending = true;
+    this->m_next = (this->m_next + 1) % m_slot_count;
+
+    // Pick up whatever finished in the meantime, oldest first to keep order
+    while (this->m_slots[this->m_oldest].pending &&
+        this->retire_oldest(false))
+    {
+    }
+}
+
+// Copies the oldest pending frame out of its PBO and hands it to the writer.
+// Without `wait` this only happens if its fence has already signalled.
+bool PixelStreamer::retire_oldest(bool wait) noexcept
+{
+    Slot& slot{ this->m_slots[this->m_oldest] };
+
+    GLenum status{ glClientWaitSync(slot.fence,
+        wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0,
+        wait ? GL_TIMEOUT_IGNORED : 0) };
+    if (status == GL_TIMEOUT_EXPIRED)
+        return false;
+
+    glDeleteSync(slot.fence);
+    slot.fence = nullptr;
+    slot.pending = false;
+    this->m_oldest = (this->m_oldest + 1) % m_slot_count;
+
+    std::vector<std::uint8_t> frame{};
+    {
+        std::unique_lock<std::mutex> lock{ this->m_queue_mutex };
+
+        // Backpressure: the consumer is too slow, so wait for it
+        this->m_queue_condition.wait(lock, [this]() {
+            return this->m_queue.size() < m_max_queued_frames ||
+                this->m_failed;
+        });
+
+        // Nobody is listening any more, so the frame can be dropped
+        if (this->m_failed)
+            return true;
+
+        if (!this->m_free_frames.empty())
+        {
+            frame = std::move(this->m_free_frames.back());
+            this->m_free_frames.pop_back();
+        }
+    }
+    frame.resize(this->m_frame_size);
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer_id);
+    const void* pixels{ glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0,
+        static_cast<GLsizeiptr>(this->m_frame_size), GL_MAP_READ_BIT) };
+    if (pixels)
+    {
+        std::memcpy(frame.data(), pixels, this->m_frame_size);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    {
+        std::lock_guard<std::mutex> lock{ this->m_queue_mutex };
+        this->m_queue.push_back(std::move(frame));
+    }
+    this->m_queue_condition.notify_all();
+
+    return true;
+}
+
+// Drains every frame still in flight and waits for the writer to finish
+void PixelStreamer::finish() noexcept
+{
+    while (this->m_slots[this->m_oldest].pending)
+        this->retire_oldest(true);
+
+    if (this->m_writer.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock{ this->m_queue_mutex };
+            this->m_finished = true;
+        }
+        this->m_queue_condition.notify_all();
+        this->m_writer.join();
+    }
+}
+
+bool PixelStreamer::has_failed() noexcept
+{
+    std::lock_guard<std::mutex> lock{ this->m_queue_mutex };
+    return this->m_failed;
+}
+
+void PixelStreamer::run_writer() noexcept
+{
+    if (this->m_format == StreamFormat::y4m)
+    {
+        // Frame rates like 59.94 are written as a ratio over 1000
+        auto rate{ static_cast<long long>((this->m_rate * 1000.0) + 0.5) };
+        std::string header{ "YUV4MPEG2 W" + std::to_string(this->m_width) +
+            " H" + std::to_string(this->m_height) +
+            " F" + std::to_string(rate) + ":1000 Ip A1:1 C444\n" };
+
+        if (!this->write_all(header.data(), header.size()))
+            return;
+    }
+
+    std::vector<std::uint8_t> converted{};
+
+    while (true)
+    {
+        std::vector<std::uint8_t> frame{};
+        {
+            std::unique_lock<std::mutex> lock{ this->m_queue_mutex };
+            this->m_queue_condition.wait(lock, [this]() {
+                return !this->m_queue.empty() || this->m_finished;
+            });
+
+            if (this->m_queue.empty())
+                return;
+
+            frame = std::move(this->m_queue.front());
+            this->m_queue.pop_front();
+        }
+        this->m_queue_condition.notify_all();
+
+        this->convert(frame, converted);
+
+        if (this->m_format == StreamFormat::y4m &&
+            !this->write_all("FRAME\n", 6))
+            return;
+        if (!this->write_all(converted.data(), converted.size()))
+            return;
+
+        std::lock_guard<std::mutex> lock{ this->m_queue_mutex };
+        this->m_free_frames.push_back(std::move(frame));
+    }
+}
+
+bool PixelStreamer::write_all(const void* data, std::size_t size) noexcept
+{
+    const char* bytes{ static_cast<const char*>(data) };
+
+    while (size > 0)
+    {
+#ifdef _WIN32
+        int written{ _write(this->m_fd, bytes,
+            static_cast<unsigned int>(size)) };
+#else
+        ssize_t written{ write(this->m_fd, bytes, size) };
+#endif
+        if (written <= 0)
+        {
+            std::cerr << "Error: Unable to write the frame stream\n";
+
+            {
+                std::lock_guard<std::mutex> lock{ this->m_queue_mutex };
+                this->m_failed = true;
+            }
+            this->m_queue_condition.notify_all();
+            return false;
+        }
+
+        bytes += written;
+        size -= static_cast<std::size_t>(written);
+    }
+
+    return true;
+}
+
+// Flips the bottom-up GL rows and converts to the output format. Y4M uses
+// BT.601 limited range, which is what video tools assume for it by default.
+void PixelStreamer::convert(const std::vector<std::uint8_t>& frame,
+    std::vector<std::uint8_t>& output) const noexcept
+{
+    std::size_t pixel_count{ static_cast<std::size_t>(this->m_width) *
+        this->m_height };
+    std::size_t row_size{ static_cast<std::size_t>(this->m_width) * 4 };
+
+    if (this->m_format == StreamFormat::rgba)
+    {
+        output.resize(this->m_frame_size);
+        for (GLsizei y{ 0 }; y < this->m_height; y++)
+            std::memcpy(output.data() + (y * row_size),
+                frame.data() + ((this->m_height - 1 - y) * row_size),
+                row_size);
+        return;
+    }
+
+    output.resize(pixel_count * 3);
+    std::uint8_t* luma{ output.data() };
+    std::uint8_t* blue_chroma{ luma + pixel_count };
+    std::uint8_t* red_chroma{ blue_chroma + pixel_count };
+
+    for (GLsizei y{ 0 }; y < this->m_height; y++)
+    {
+        const std::uint8_t* source{ frame.data() +
+            ((this->m_height - 1 - y) * row_size) };
+
+        for (GLsizei x{ 0 }; x < this->m_width; x++)
+        {
+            int red{ source[(x * 4) + 0] };
+            int green{ source[(x * 4) + 1] };
+            int blue{ source[(x * 4) + 2] };
+            std::size_t index{ (static_cast<std::size_t>(y) * this->m_width) +
+                x };
+
+            luma[index] = static_cast<std::uint8_t>(
+                ((66 * red + 129 * green + 25 * blue + 128) >> 8) + 16);
+            blue_chroma[index] = static_cast<std::uint8_t>(
+                ((-38 * red - 74 * green + 112 * blue + 128) >> 8) + 128);
+            red_chroma[index] = static_cast<std::uint8_t>(
+                ((112 * red - 94 * green - 18 * blue + 128) >> 8) + 128);
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,300 @@
+#include <glad/glad.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#ifdef _WIN32
+#  include <process.h>
+#else
+#  include <unistd.h>
+#endif
+
+#pragma once
+
+#ifndef PROGRAM_CACHE_HPP
+#  define PROGRAM_CACHE_HPP
+
+// 64-bit FNV-1a, which is plenty to tell shader sources and drivers apart
+std::uint64_t fnv1a_64(std::string_view data,
+    std::uint64_t hash = 14695981039346656037ull) noexcept
+{
+    for (char c : data)
+    {
+        hash ^= static_cast<std::uint8_t>(c);
+        hash *= 1099511628211ull;
+    }
+
+    return hash;
+}
+
+struct ProgramCacheStats
+{
+    int loaded{};
+    int compiled{};
+
+    // Programs whose cached binary the driver refused, e.g. after an update
+    // that kept the version string
+    int rejected{};
+
+    double load_milliseconds{};
+    double compile_milliseconds{};
+
+    // What compiling the programs that were loaded would have cost, as
+    // recorded when their binaries were stored
+    double saved_milliseconds{};
+};
+
+// Keeps linked program binaries on disk, so a restart skips compiling and
+// linking GLSL. Binaries are keyed by a hash of the sources together with
+// the vendor, renderer and version strings of the driver, and a binary the
+// driver turns down anyway is simply compiled from source again.
+//
+// Needs GL 4.1 or ARB_get_program_binary with at least one binary format;
+// without them, or when disabled, every program is compiled from source.
+class ProgramCache
+{
+    std::string m_directory{ ".shader-cache" };
+    bool m_enabled{ true };
+    ProgramCacheStats m_stats{};
+
+    struct FileHeader
+    {
+        char magic[8]{ 'C', 'L', 'K', 'P', 'R', 'O', 'G', '1' };
+        std::uint64_t key{};
+        std::uint32_t format{};
+        std::uint32_t length{};
+        double compile_milliseconds{};
+    };
+
+    // Program binaries are tens to hundreds of KiB
+    static constexpr std::uint32_t max_binary_length{ 64u << 20 };
+
+    std::string get_path(std::uint64_t) const noexcept;
+
+public:
+    void set_directory(std::string) noexcept;
+    void set_enabled(bool) noexcept;
+    bool is_supported() const noexcept;
+
+    std::uint64_t make_key(std::string_view, std::string_view,
+        std::string_view = {}) const noexcept;
+
+    void prepare(GLuint) const noexcept;
+    bool load(std::uint64_t, GLuint) noexcept;
+    void store(std::uint64_t, GLuint, double) noexcept;
+
+    const ProgramCacheStats& get_stats() const noexcept;
+    void reset_stats() noexcept;
+    void print_stats() const noexcept;
+};
+
+void ProgramCache::set_directory(std::string directory) noexcept
+{
+    this->m_directory = std::move(directory);
+}
+
+void ProgramCache::set_enabled(bool enabled) noexcept
+{
+    this->m_enabled = enabled;
+}
+
+bool ProgramCache::is_supported() const noexcept
+{
+    // glad only loads the GL 4.1 entry points for a 4.1 context or newer;
+    // drivers asked for 3.3 core usually give us the newest core one anyway
+    if (!this->m_enabled || !GLAD_GL_VERSION_4_1)
+        return false;
+
+    GLint format_count{};
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &format_count);
+    return format_count > 0;
+}
+
+std::uint64_t ProgramCache::make_key(std::string_view vertex_source,
+    std::string_view fragment_source, std::string_view defines) const noexcept
+{
+    std::uint64_t key{ fnv1a_64(vertex_source) };
+    key = fnv1a_64(std::string_view{ "\0", 1 }, key);
+    key = fnv1a_64(fragment_source, key);
+    key = fnv1a_64(std::string_view{ "\0", 1 }, key);
+    key = fnv1a_64(defines, key);
+
+    for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION })
+    {
+        const char* value{
+            reinterpret_cast<const char*>(glGetString(name)) };
+        key = fnv1a_64(std::string_view{ "\0", 1 }, key);
+        if (value)
+            key = fnv1a_64(value, key);
+    }
+
+    return key;
+}
+
+std::string ProgramCache::get_path(std::uint64_t key) const noexcept
+{
+    std::ostringstream name{};
+    name << std::hex << std::setw(16) << std::setfill('0') << key << ".bin";
+
+    return (std::filesystem::path{ this->m_directory } / name.str()).string();
+}
+
+// Asks the driver to keep the binary of a program that is about to be linked
+void ProgramCache::prepare(GLuint program_id) const noexcept
+{
+    if (this->is_supported())
+        glProgramParameteri(program_id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT,
+            GL_TRUE);
+}
+
+// Links the program from its cached binary. Returns false when there is no
+// usable binary, leaving the program to be compiled from source.
+bool ProgramCache::load(std::uint64_t key, GLuint program_id) noexcept
+{
+    if (!this->is_supported())
+        return false;
+
+    auto begin{ std::chrono::steady_clock::now() };
+
+    std::string path{ this->get_path(key) };
+    std::error_code error{};
+    std::uintmax_t file_size{ std::filesystem::file_size(path, error) };
+    if (error)
+        return false;
+
+    std::ifstream file{ path, std::ios::in | std::ios::binary };
+    FileHeader header{};
+    if (!file || !file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, FileHeader{}.magic, sizeof(header.magic)) ||
+        header.key != key)
+        return false;
+
+    // A length that does not match the file, e.g. from a truncated or
+    // corrupt file, is a miss rather than a huge allocation
+    if (header.length > max_binary_length ||
+        sizeof(header) + header.length != file_size)
+        return false;
+
+    std::vector<char> binary(header.length);
+    if (!file.read(binary.data(), static_cast<std::streamsize>(binary.size())))
+        return false;
+
+    glProgramBinary(program_id, header.format, binary.data(),
+        static_cast<GLsizei>(binary.size()));
+
+    GLint status{};
+    glGetProgramiv(program_id, GL_LINK_STATUS, &status);
+    if (!status)
+    {
+        this->m_stats.rejected++;
+        return false;
+    }
+
+    double milliseconds{ std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - begin).count() };
+
+    this->m_stats.loaded++;
+    this->m_stats.load_milliseconds += milliseconds;
+    this->m_stats.saved_milliseconds +=
+        header.compile_milliseconds - milliseconds;
+    return true;
+}
+
+// Writes the binary of a freshly linked program along with what compiling it
+// took. The file is written under a temporary name of its own and renamed
+// into place, so a process starting at the same time never reads half a
+// binary, even when another one is storing the same program.
+void ProgramCache::store(std::uint64_t key, GLuint program_id,
+    double compile_milliseconds) noexcept
+{
+    this->m_stats.compiled++;
+    this->m_stats.compile_milliseconds += compile_milliseconds;
+
+    if (!this->is_supported())
+        return;
+
+    GLint length{};
+    glGetProgramiv(program_id, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
+
+    FileHeader header{};
+    header.key = key;
+    header.length = static_cast<std::uint32_t>(length);
+    header.compile_milliseconds = compile_milliseconds;
+
+    std::vector<char> binary(header.length);
+    GLenum format{};
+    glGetProgramBinary(program_id, length, nullptr, &format, binary.data());
+    header.format = format;
+
+    std::error_code error{};
+    std::filesystem::create_directories(this->m_directory, error);
+
+    std::string path{ this->get_path(key) };
+#ifdef _WIN32
+    long process_id{ static_cast<long>(_getpid()) };
+#else
+    long process_id{ static_cast<long>(getpid()) };
+#endif
+    std::string temporary_path{ path + "." + std::to_string(process_id) +
+        ".tmp" };
+    {
+        std::ofstream file{ temporary_path,
+            std::ios::out | std::ios::binary | std::ios::trunc };
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(binary.data(), static_cast<std::streamsize>(binary.size()));
+
+        if (!file)
+        {
+            std::cerr << "Error: Unable to write shader cache file '"
+                      << temporary_path << "'\n";
+            return;
+        }
+    }
+
+    std::filesystem::rename(temporary_path, path, error);
+    if (error)
+        std::filesystem::remove(temporary_path, error);
+}
+
+const ProgramCacheStats& ProgramCache::get_stats() const noexcept
+{
+    return this->m_stats;
+}
+
+void ProgramCache::reset_stats() noexcept
+{
+    this->m_stats = ProgramCacheStats{};
+}
+
+void ProgramCache::print_stats() const noexcept
+{
+    std::ios::fmtflags flags{ std::cerr.flags() };
+
+    std::cerr << "Shader cache:     " << this->m_stats.loaded << " loaded, "
+              << this->m_stats.compiled << " compiled";
+    if (this->m_stats.rejected > 0)
+        std::cerr << " (" << this->m_stats.rejected << " stale)";
+    std::cerr << std::fixed << std::setprecision(1) << ", "
+              << (this->m_stats.load_milliseconds +
+                  this->m_stats.compile_milliseconds)
+              << " ms, saved " << this->m_stats.saved_milliseconds << " ms\n";
+
+    std::cerr.flags(flags);
+}
+
+// Shared by every ShaderProgram, configured from the options at startup
+ProgramCache program_cache{};
+
+#endif
@@ -0,0 +1,134 @@
+#include <cstddef>
+#include <ctime>
+
+#pragma once
+
+#ifndef REDRAW_TRACKER_HPP
+#  define REDRAW_TRACKER_HPP
+
+// Collects everything that can change what is on screen, so the main loop
+// only renders and swaps when the picture would actually be different
+class RedrawTracker
+{
+    bool m_dirty{ true };
+    bool m_focused{ true };
+    bool m_iconified{ false };
+    int m_framebuffer_width{};
+    int m_framebuffer_height{};
+    std::size_t m_theme{};
+    std::time_t m_displayed_second{ -1 };
+
+public:
+    void mark_dirty() noexcept;
+
+    void set_displayed_second(std::time_t) noexcept;
+    void set_framebuffer_size(int, int) noexcept;
+    void set_focused(bool) noexcept;
+    void set_iconified(bool) noexcept;
+    void set_theme(std::size_t) noexcept;
+
+    std::time_t get_displayed_second() const noexcept;
+    int get_framebuffer_width() const noexcept;
+    int get_framebuffer_height() const noexcept;
+    bool is_focused() const noexcept;
+    bool is_iconified() const noexcept;
+    std::size_t get_theme() const noexcept;
+
+    bool needs_redraw() const noexcept;
+    void clear() noexcept;
+};
+
+void RedrawTracker::mark_dirty() noexcept
+{
+    this->m_dirty = true;
+}
+
+void RedrawTracker::set_displayed_second(std::time_t second) noexcept
+{
+    if (second != this->m_displayed_second)
+    {
+        this->m_displayed_second = second;
+        this->m_dirty = true;
+    }
+}
+
+void RedrawTracker::set_framebuffer_size(int width, int height) noexcept
+{
+    if (width != this->m_framebuffer_width ||
+        height != this->m_framebuffer_height)
+    {
+        this->m_framebuffer_width = width;
+        this->m_framebuffer_height = height;
+        this->m_dirty = true;
+    }
+}
+
+void RedrawTracker::set_focused(bool focused) noexcept
+{
+    if (focused != this->m_focused)
+    {
+        this->m_focused = focused;
+        this->m_dirty = true;
+    }
+}
+
+void RedrawTracker::set_iconified(bool iconified) noexcept
+{
+    if (iconified != this->m_iconified)
+    {
+        this->m_iconified = iconified;
+        this->m_dirty = true;
+    }
+}
+
+void RedrawTracker::set_theme(std::size_t theme) noexcept
+{
+    if (theme != this->m_theme)
+    {
+        this->m_theme = theme;
+        this->m_dirty = true;
+    }
+}
+
+std::time_t RedrawTracker::get_displayed_second() const noexcept
+{
+    return this->m_displayed_second;
+}
+
+int RedrawTracker::get_framebuffer_width() const noexcept
+{
+    return this->m_framebuffer_width;
+}
+
+int RedrawTracker::get_framebuffer_height() const noexcept
+{
+    return this->m_framebuffer_height;
+}
+
+bool RedrawTracker::is_focused() const noexcept
+{
+    return this->m_focused;
+}
+
+bool RedrawTracker::is_iconified() const noexcept
+{
+    return this->m_iconified;
+}
+
+std::size_t RedrawTracker::get_theme() const noexcept
+{
+    return this->m_theme;
+}
+
+// Nothing is visible while iconified, so the redraw waits for the restore
+bool RedrawTracker::needs_redraw() const noexcept
+{
+    return this->m_dirty && !this->m_iconified;
+}
+
+void RedrawTracker::clear() noexcept
+{
+    this->m_dirty = false;
+}
+
+#endif
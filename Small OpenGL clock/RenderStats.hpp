@@ -0,0 +1,184 @@
+#include <glad/glad.h>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string_view>
+
+#ifdef _WIN32
+#  ifndef WIN32_LEAN_AND_MEAN
+#    define WIN32_LEAN_AND_MEAN
+#  endif
+#  ifndef NOMINMAX
+#    define NOMINMAX
+#  endif
+#  include <windows.h>
+#else
+#  include <sys/resource.h>
+#endif
+
+#pragma once
+
+#ifndef RENDER_STATS_HPP
+#  define RENDER_STATS_HPP
+
+// Measures GPU time of the enclosed commands with GL_TIME_ELAPSED queries.
+// Several queries are kept in flight and results are only collected once they
+// are available, so timing a frame never waits on the GPU.
+class GpuTimer
+{
+    static constexpr std::size_t m_query_count{ 4 };
+
+    std::array<GLuint, m_query_count> m_queries{};
+    std::array<bool, m_query_count> m_pending{};
+    std::size_t m_next{};
+
+    std::uint64_t m_samples{};
+    std::uint64_t m_total_nanoseconds{};
+
+public:
+    GpuTimer() noexcept;
+    ~GpuTimer() noexcept;
+
+    GpuTimer(const GpuTimer&) = delete;
+    GpuTimer& operator=(const GpuTimer&) = delete;
+
+    void begin() noexcept;
+    void end() noexcept;
+    void collect(bool = false) noexcept;
+
+    std::uint64_t get_samples() const noexcept;
+    double get_mean_milliseconds() const noexcept;
+    double get_total_milliseconds() const noexcept;
+};
+
+GpuTimer::GpuTimer() noexcept
+{
+    glGenQueries(static_cast<GLsizei>(m_query_count), this->m_queries.data());
+}
+
+GpuTimer::~GpuTimer() noexcept
+{
+    glDeleteQueries(static_cast<GLsizei>(m_query_count),
+        this->m_queries.data());
+}
+
+void GpuTimer::begin() noexcept
+{
+    // Every query is still in flight; give up the oldest result rather than
+    // stall the pipeline waiting for it
+    if (this->m_pending[this->m_next])
+        this->collect();
+    this->m_pending[this->m_next] = false;
+
+    glBeginQuery(GL_TIME_ELAPSED, this->m_queries[this->m_next]);
+}
+
+void GpuTimer::end() noexcept
+{
+    glEndQuery(GL_TIME_ELAPSED);
+
+    this->m_pending[this->m_next] = true;
+    this->m_next = (this->m_next + 1) % m_query_count;
+}
+
+// Picks up every finished result; with `wait` set it blocks until all of them
+// are in, which is meant for the end of a run or a benchmark
+void GpuTimer::collect(bool wait) noexcept
+{
+    for (std::size_t i{ 0 }; i < m_query_count; i++)
+    {
+        if (!this->m_pending[i])
+            continue;
+
+        GLint available{ GL_FALSE };
+        if (!wait)
+            glGetQueryObjectiv(this->m_queries[i], GL_QUERY_RESULT_AVAILABLE,
+                &available);
+
+        if (wait || available)
+        {
+            GLuint64 elapsed{};
+            glGetQueryObjectui64v(this->m_queries[i], GL_QUERY_RESULT,
+                &elapsed);
+
+            this->m_samples++;
+            this->m_total_nanoseconds += elapsed;
+            this->m_pending[i] = false;
+        }
+    }
+}
+
+std::uint64_t GpuTimer::get_samples() const noexcept
+{
+    return this->m_samples;
+}
+
+double GpuTimer::get_mean_milliseconds() const noexcept
+{
+    if (this->m_samples == 0)
+        return 0.0;
+
+    return this->get_total_milliseconds() /
+        static_cast<double>(this->m_samples);
+}
+
+double GpuTimer::get_total_milliseconds() const noexcept
+{
+    return static_cast<double>(this->m_total_nanoseconds) / 1e6;
+}
+
+// CPU time used by the whole process so far, user plus system
+double process_cpu_seconds() noexcept
+{
+#ifdef _WIN32
+    FILETIME creation{}, exit{}, kernel{}, user{};
+    GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user);
+
+    auto to_seconds = [](const FILETIME& time) {
+        ULARGE_INTEGER value{};
+        value.LowPart = time.dwLowDateTime;
+        value.HighPart = time.dwHighDateTime;
+        return static_cast<double>(value.QuadPart) / 1e7;
+    };
+
+    return to_seconds(kernel) + to_seconds(user);
+#else
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+
+    return static_cast<double>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) +
+        (static_cast<double>(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) /
+            1e6);
+#endif
+}
+
+// CPU and GPU cost of one render mode over a run, so the modes can be
+// compared per site
+struct RenderStats
+{
+    std::uint64_t frames{};
+    double cpu_seconds{};
+    double wall_seconds{};
+
+    void print(std::string_view, const GpuTimer&) const noexcept;
+};
+
+void RenderStats::print(std::string_view mode, const GpuTimer& gpu_timer)
+const noexcept
+{
+    double seconds{ this->wall_seconds > 0.0 ? this->wall_seconds : 1.0 };
+
+    std::cerr << "Render mode:      " << mode << '\n'
+              << "Frames rendered:  " << this->frames << " ("
+              << (static_cast<double>(this->frames) / seconds) << " fps)\n"
+              << "CPU usage:        "
+              << ((this->cpu_seconds / seconds) * 100.0) << " %\n"
+              << "GPU time/frame:   " << gpu_timer.get_mean_milliseconds()
+              << " ms\n"
+              << "GPU time/second:  "
+              << (gpu_timer.get_total_milliseconds() / seconds) << " ms\n";
+}
+
+#endif
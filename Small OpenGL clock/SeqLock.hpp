@@ -0,0 +1,85 @@
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#pragma once
+
+#ifndef SEQ_LOCK_HPP
+#  define SEQ_LOCK_HPP
+
+// Single writer, many readers. Readers never block the writer and never take
+// a lock; they retry in the rare case that a write happened while they were
+// copying. The value is kept in atomic words so the racing copy is not a data
+// race in the C++ sense.
+template <typename T>
+class SeqLock
+{
+    static_assert(std::is_trivially_copyable_v<T>,
+        "SeqLock values are copied word by word");
+
+    static constexpr std::size_t m_word_count{
+        (sizeof(T) + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t) };
+
+    std::atomic<std::uint32_t> m_sequence{ 0 };
+    std::array<std::atomic<std::uint64_t>, m_word_count> m_words{};
+
+public:
+    SeqLock() noexcept;
+    explicit SeqLock(const T&) noexcept;
+
+    void store(const T&) noexcept;
+    T load() const noexcept;
+};
+
+template <typename T>
+SeqLock<T>::SeqLock() noexcept : SeqLock{ T{} }
+{
+}
+
+template <typename T>
+SeqLock<T>::SeqLock(const T& value) noexcept
+{
+    this->store(value);
+}
+
+template <typename T>
+void SeqLock<T>::store(const T& value) noexcept
+{
+    std::uint64_t words[m_word_count]{};
+    std::memcpy(words, &value, sizeof(T));
+
+    std::uint32_t sequence{ this->m_sequence.load(std::memory_order_relaxed) };
+    this->m_sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    for (std::size_t i{ 0 }; i < m_word_count; i++)
+        this->m_words[i].store(words[i], std::memory_order_relaxed);
+
+    this->m_sequence.store(sequence + 2, std::memory_order_release);
+}
+
+template <typename T>
+T SeqLock<T>::load() const noexcept
+{
+    std::uint64_t words[m_word_count]{};
+    std::uint32_t before{}, after{};
+
+    do
+    {
+        before = this->m_sequence.load(std::memory_order_acquire);
+
+        for (std::size_t i{ 0 }; i < m_word_count; i++)
+            words[i] = this->m_words[i].load(std::memory_order_relaxed);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        after = this->m_sequence.load(std::memory_order_relaxed);
+    } while ((before & 1) || before != after);
+
+    T value{};
+    std::memcpy(&value, words, sizeof(T));
+    return value;
+}
+
+#endif
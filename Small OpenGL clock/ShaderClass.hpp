@@ -1,9 +1,19 @@
+#include "AssetPack.hpp"
+#include "ProgramCache.hpp"
+
 #include <glad/glad.h>
 
-#include <fstream>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
 #include <iostream>
-#include <sstream>
+#include <map>
+#include <memory>
 #include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -14,29 +24,194 @@
 #ifndef SHADER_CLASS_HPP
 #  define SHADER_CLASS_HPP
 
+// The source of a shader: a view straight into the asset pack when it has
+// the file, and otherwise the loose file read into `storage`
+std::string_view load_shader_source(const std::string& shader_path,
+    std::string& storage) noexcept
+{
+    std::string_view source{};
+    if (asset_pack.find(shader_path, source))
+        return source;
+
+    if (!read_file(shader_path, storage))
+        std::cerr << "Error: Unable to open shader '" << shader_path << "'\n";
+
+    return storage;
+}
+
+// Set once the driver has been told to compile shaders on threads of its own
+// through GL_KHR_parallel_shader_compile, which also makes it possible to
+// ask whether a link has finished without waiting for it
+bool parallel_shader_compile{ false };
+
+#ifndef GL_MAX_SHADER_COMPILER_THREADS_KHR
+#  define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#endif
+#ifndef GL_COMPLETION_STATUS_KHR
+#  define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+// Looks for GL_KHR_parallel_shader_compile or its ARB predecessor and lets
+// the driver use as many compiler threads as it likes. glad is generated
+// without extensions, so the entry point comes from the context's loader.
+void enable_parallel_shader_compile(GLADloadproc load) noexcept
+{
+    if (!load)
+        return;
+
+    GLint extension_count{};
+    glGetIntegerv(GL_NUM_EXTENSIONS, &extension_count);
+
+    const char* function_name{};
+    for (GLint i{ 0 }; i < extension_count && !function_name; i++)
+    {
+        std::string_view extension{ reinterpret_cast<const char*>(
+            glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i))) };
+
+        if (extension == "GL_KHR_parallel_shader_compile")
+            function_name = "glMaxShaderCompilerThreadsKHR";
+        else if (extension == "GL_ARB_parallel_shader_compile")
+            function_name = "glMaxShaderCompilerThreadsARB";
+    }
+
+    if (!function_name)
+        return;
+
+    using max_threads_function = void (APIENTRY*)(GLuint);
+    auto max_shader_compiler_threads{
+        reinterpret_cast<max_threads_function>(load(function_name)) };
+    if (!max_shader_compiler_threads)
+        return;
+
+    max_shader_compiler_threads(0xffffffffu);
+    parallel_shader_compile = true;
+}
+
+// Preprocessor definitions a program is specialized with, by name. Being
+// sorted, the same set always turns into the same block of #defines.
+using ShaderDefines = std::map<std::string, std::string, std::less<>>;
+
+std::string make_define_block(const ShaderDefines& defines) noexcept
+{
+    std::string block{};
+    for (const auto& [name, value] : defines)
+        block.append("#define ").append(name).append(" ").append(value)
+            .append("\n");
+
+    return block;
+}
+
+// A shader handed to the driver to compile. Its status is only checked on
+// request, so several shaders can be compiling at the same time.
 class Shader
 {
     GLuint m_shader_id{};
 
 public:
-    Shader(const std::string & = "", GLenum = GL_VERTEX_SHADER) noexcept;
+    Shader() noexcept = default;
+    Shader(std::string_view, GLenum, std::string_view = {}) noexcept;
+
+    bool check_compile_status() const noexcept;
 
     GLuint get_shader_id() const noexcept;
 };
 
-Shader::Shader(const std::string& shader_path,
-    GLenum type) noexcept
+// Finds the end of the #version line of a shader, past any blank lines and
+// comments before it, or npos when the first directive is not #version
+std::size_t find_version_line_end(std::string_view source) noexcept
 {
-    std::ifstream shader_source_file{ shader_path, std::ios::in };
-    std::stringstream shader_source_str{};
-    shader_source_str << shader_source_file.rdbuf();
-    std::string shader_souce_file_rdbuf{ shader_source_str.str() };
-    const char* shader_source_ptr{ shader_souce_file_rdbuf.c_str() };
+    std::size_t position{ 0 };
+    while (position < source.size())
+    {
+        char c{ source[position] };
+        if (c == ' ' || c == '\t' || c == '\r' || c == '\n')
+            position++;
+        else if (source.substr(position, 2) == "//")
+            position = source.find('\n', position);
+        else if (source.substr(position, 2) == "/*")
+        {
+            position = source.find("*/", position + 2);
+            if (position != std::string_view::npos)
+                position += 2;
+        }
+        else
+            break;
+    }
+
+    if (position >= source.size() || source[position] != '#')
+        return std::string_view::npos;
+
+    std::size_t name{ source.find_first_not_of(" \t", position + 1) };
+    if (name == std::string_view::npos ||
+        source.substr(name, 7) != "version")
+        return std::string_view::npos;
+
+    std::size_t end{ source.find('\n', name) };
+    return end == std::string_view::npos ? source.size() : end + 1;
+}
+
+// Compiles `shader_source` with a block of #defines inserted right after its
+// #version line, which has to come before anything else. The source itself
+// is still passed to the driver in place, as the strings around the defines.
+Shader::Shader(std::string_view shader_source, GLenum type,
+    std::string_view define_block) noexcept
+{
+    // Drivers do not expect a byte order mark in front of #version
+    std::string_view body{ shader_source };
+    if (body.substr(0, 3) == "\xEF\xBB\xBF")
+        body.remove_prefix(3);
+
+    std::string_view version{};
+    if (!define_block.empty())
+    {
+        std::size_t version_end{ find_version_line_end(body) };
+        if (version_end == std::string_view::npos)
+        {
+            std::cerr << "Error: Shader has no #version line to put its "
+                         "#defines after\n";
+            define_block = {};
+        }
+        else
+        {
+            version = body.substr(0, version_end);
+            body.remove_prefix(version_end);
+        }
+    }
+
+    // Keeps the line numbers in compile errors those of the file
+    std::string prologue{};
+    if (!define_block.empty())
+    {
+        std::size_t lines{ static_cast<std::size_t>(
+            std::count(version.begin(), version.end(), '\n')) };
+        if (!version.empty() && version.back() != '\n')
+            prologue.append("\n");
+        prologue.append(define_block).append("#line ")
+            .append(std::to_string(lines + 1)).append("\n");
+    }
+
+    // Empty views may have no data at all, which drivers refuse as a string
+    const char* strings[3]{};
+    GLint lengths[3]{};
+    GLsizei count{ 0 };
+    for (std::string_view part : { version, std::string_view{ prologue }, body })
+    {
+        if (part.empty())
+            continue;
+
+        strings[count] = part.data();
+        lengths[count] = static_cast<GLint>(part.size());
+        count++;
+    }
 
     m_shader_id = glCreateShader(type);
-    glShaderSource(this->m_shader_id, 1, &shader_source_ptr, nullptr);
+    glShaderSource(this->m_shader_id, count, strings, lengths);
     glCompileShader(this->m_shader_id);
+}
 
+// Waits for the compile to finish and reports it if it failed
+bool Shader::check_compile_status() const noexcept
+{
     GLint status;
     char buffer[512];
     glGetShaderiv(this->m_shader_id, GL_COMPILE_STATUS, &status);
@@ -45,6 +220,8 @@ Shader::Shader(const std::string& shader_path,
         glGetShaderInfoLog(this->m_shader_id, 512, nullptr, buffer);
         std::cerr << "Error: Shader compilation failed:\n" << buffer << '\n';
     }
+
+    return status;
 }
 
 GLuint Shader::get_shader_id() const noexcept
@@ -52,130 +229,535 @@ GLuint Shader::get_shader_id() const noexcept
     return this->m_shader_id;
 }
 
+// A uniform location resolved once, for setting uniforms on the per-frame
+// path without any string lookup. The default handle refers to no uniform and
+// setting it does nothing, like an inactive uniform in GL.
+struct Uniform
+{
+    GLint location{ -1 };
+};
+
+// A linked program. Constructing one only issues the compile and link, and
+// the result is checked the first time the program is used, so programs
+// constructed one after the other compile at the same time wherever the
+// driver can do that.
 class ShaderProgram
 {
     GLuint m_program_id{};
-    Shader m_vertex_shader{};
-    Shader m_fragment_shader{};
 
-public:
-    ShaderProgram(const std::string&, const std::string&) noexcept;
+    // A link that has been issued but not checked yet, with the shaders it
+    // was issued with and what issuing it cost
+    mutable bool m_link_pending{ false };
+    mutable bool m_linked{ false };
+    mutable Shader m_vertex_shader{};
+    mutable Shader m_fragment_shader{};
+    mutable std::uint64_t m_cache_key{};
+    mutable double m_issue_milliseconds{};
 
-    void activate_program() const noexcept;
+    // Every active uniform by name, resolved right after linking. Arrays are
+    // listed under their bare name as well as "name[0]".
+    mutable std::map<std::string, GLint, std::less<>> m_uniform_locations{};
+
+    void finish_link() const noexcept;
+    void resolve_uniforms() const noexcept;
 
-    void set_bool(const std::string&, GLboolean) const noexcept;
-    void set_int(const std::string&, GLint) const noexcept;
-    void set_float(const std::string&, GLfloat) const noexcept;
+public:
+    ShaderProgram(const std::string&, const std::string&,
+        const ShaderDefines& = {}) noexcept;
+    ~ShaderProgram() noexcept;
+
+    ShaderProgram(const ShaderProgram&) = delete;
+    ShaderProgram& operator=(const ShaderProgram&) = delete;
+    ShaderProgram(ShaderProgram&&) noexcept;
+    ShaderProgram& operator=(ShaderProgram&&) noexcept;
 
-    void set_vec1(const std::string&, const glm::vec1&) const noexcept;
-    void set_vec2(const std::string&, const glm::vec2&) const noexcept;
-    void set_vec3(const std::string&, const glm::vec3&) const noexcept;
+    bool is_link_complete() const noexcept;
+    bool is_linked() const noexcept;
+    void activate_program() const noexcept;
 
-    void set_mat2(const std::string&, const glm::mat2&) const noexcept;
-    void set_mat3(const std::string&, const glm::mat3&) const noexcept;
-    void set_mat4(const std::string&, const glm::mat4&) const noexcept;
+    Uniform get_uniform(std::string_view) const noexcept;
+    void set_uniform_block_binding(std::string_view, GLuint) const noexcept;
+
+    void set_bool(Uniform, GLboolean) const noexcept;
+    void set_bool(std::string_view, GLboolean) const noexcept;
+    void set_int(Uniform, GLint) const noexcept;
+    void set_int(std::string_view, GLint) const noexcept;
+    void set_float(Uniform, GLfloat) const noexcept;
+    void set_float(std::string_view, GLfloat) const noexcept;
+
+    void set_vec1(Uniform, const glm::vec1&) const noexcept;
+    void set_vec1(std::string_view, const glm::vec1&) const noexcept;
+    void set_vec2(Uniform, const glm::vec2&) const noexcept;
+    void set_vec2(std::string_view, const glm::vec2&) const noexcept;
+    void set_vec3(Uniform, const glm::vec3&) const noexcept;
+    void set_vec3(std::string_view, const glm::vec3&) const noexcept;
+
+    void set_float_array(Uniform, const GLfloat*, GLsizei) const noexcept;
+    void set_float_array(std::string_view, const GLfloat*, GLsizei) const
+        noexcept;
+    void set_vec3_array(Uniform, const glm::vec3*, GLsizei) const noexcept;
+    void set_vec3_array(std::string_view, const glm::vec3*, GLsizei) const
+        noexcept;
+
+    void set_mat2(Uniform, const glm::mat2&) const noexcept;
+    void set_mat2(std::string_view, const glm::mat2&) const noexcept;
+    void set_mat3(Uniform, const glm::mat3&) const noexcept;
+    void set_mat3(std::string_view, const glm::mat3&) const noexcept;
+    void set_mat4(Uniform, const glm::mat4&) const noexcept;
+    void set_mat4(std::string_view, const glm::mat4&) const noexcept;
 
     GLuint get_program_id() const noexcept;
 };
 
+// Links the program from the binary in program_cache when there is a usable
+// one, and issues the compiles and the link from source otherwise. Both
+// shaders are compiled with the given defines.
 ShaderProgram::ShaderProgram(const std::string& vertex_shader_path,
-    const std::string& fragment_shader_path) noexcept :
-    m_vertex_shader{ vertex_shader_path, GL_VERTEX_SHADER },
-    m_fragment_shader{ fragment_shader_path, GL_FRAGMENT_SHADER }
+    const std::string& fragment_shader_path, const ShaderDefines& defines)
+noexcept
 {
+    std::string vertex_storage{};
+    std::string fragment_storage{};
+    std::string_view vertex_source{
+        load_shader_source(vertex_shader_path, vertex_storage) };
+    std::string_view fragment_source{
+        load_shader_source(fragment_shader_path, fragment_storage) };
+
+    std::string define_block{ make_define_block(defines) };
+
     this->m_program_id = glCreateProgram();
+
+    this->m_cache_key = program_cache.make_key(vertex_source, fragment_source,
+        define_block);
+    if (program_cache.load(this->m_cache_key, this->m_program_id))
+    {
+        this->m_linked = true;
+        this->resolve_uniforms();
+        return;
+    }
+
+    auto begin{ std::chrono::steady_clock::now() };
+
+    this->m_vertex_shader = Shader{ vertex_source, GL_VERTEX_SHADER,
+        define_block };
+    this->m_fragment_shader = Shader{ fragment_source, GL_FRAGMENT_SHADER,
+        define_block };
+
     glAttachShader(this->m_program_id, this->m_vertex_shader.get_shader_id());
     glAttachShader(this->m_program_id, this->m_fragment_shader.get_shader_id());
 
+    program_cache.prepare(this->m_program_id);
     glLinkProgram(this->m_program_id);
 
+    this->m_link_pending = true;
+    this->m_issue_milliseconds = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - begin).count();
+}
+
+ShaderProgram::~ShaderProgram() noexcept
+{
+    if (this->m_link_pending)
+    {
+        glDeleteShader(this->m_vertex_shader.get_shader_id());
+        glDeleteShader(this->m_fragment_shader.get_shader_id());
+    }
+
+    glDeleteProgram(this->m_program_id);
+}
+
+ShaderProgram::ShaderProgram(ShaderProgram&& other) noexcept :
+    m_program_id{ std::exchange(other.m_program_id, 0) },
+    m_link_pending{ std::exchange(other.m_link_pending, false) },
+    m_linked{ other.m_linked },
+    m_vertex_shader{ other.m_vertex_shader },
+    m_fragment_shader{ other.m_fragment_shader },
+    m_cache_key{ other.m_cache_key },
+    m_issue_milliseconds{ other.m_issue_milliseconds },
+    m_uniform_locations{ std::move(other.m_uniform_locations) }
+{
+}
+
+ShaderProgram& ShaderProgram::operator=(ShaderProgram&& other) noexcept
+{
+    // The program and shaders this one held go away with `other`
+    std::swap(this->m_program_id, other.m_program_id);
+    std::swap(this->m_link_pending, other.m_link_pending);
+    std::swap(this->m_linked, other.m_linked);
+    std::swap(this->m_vertex_shader, other.m_vertex_shader);
+    std::swap(this->m_fragment_shader, other.m_fragment_shader);
+    std::swap(this->m_cache_key, other.m_cache_key);
+    std::swap(this->m_issue_milliseconds, other.m_issue_milliseconds);
+    std::swap(this->m_uniform_locations, other.m_uniform_locations);
+
+    return *this;
+}
+
+// Whether using the program would not have to wait for the driver. Without
+// parallel compiling there is no way to tell, so only a checked link counts.
+bool ShaderProgram::is_link_complete() const noexcept
+{
+    if (!this->m_link_pending)
+        return true;
+    if (!parallel_shader_compile)
+        return false;
+
+    GLint complete{};
+    glGetProgramiv(this->m_program_id, GL_COMPLETION_STATUS_KHR, &complete);
+    return complete;
+}
+
+// Whether the program linked, waiting for the link if it is still running
+bool ShaderProgram::is_linked() const noexcept
+{
+    this->finish_link();
+    return this->m_linked;
+}
+
+// Waits for an issued link, reports errors and stores the binary. The time
+// charged to the program cache is only what the compile held up this thread.
+void ShaderProgram::finish_link() const noexcept
+{
+    if (!this->m_link_pending)
+        return;
+    this->m_link_pending = false;
+
+    auto begin{ std::chrono::steady_clock::now() };
+
     GLint status;
     char buffer[512];
     glGetProgramiv(this->m_program_id, GL_LINK_STATUS, &status);
     if (!status)
     {
+        this->m_vertex_shader.check_compile_status();
+        this->m_fragment_shader.check_compile_status();
+
         glGetProgramInfoLog(this->m_program_id, 512, nullptr, buffer);
         std::cerr << "Error: Program linking failed:\n" << buffer << '\n';
     }
+    else
+    {
+        this->m_linked = true;
+        program_cache.store(this->m_cache_key, this->m_program_id,
+            this->m_issue_milliseconds +
+            std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - begin).count());
+        this->resolve_uniforms();
+    }
 
+    glDetachShader(this->m_program_id, this->m_vertex_shader.get_shader_id());
+    glDetachShader(this->m_program_id, this->m_fragment_shader.get_shader_id());
     glDeleteShader(this->m_vertex_shader.get_shader_id());
     glDeleteShader(this->m_fragment_shader.get_shader_id());
 }
 
+void ShaderProgram::resolve_uniforms() const noexcept
+{
+    GLint uniform_count{};
+    GLint max_name_length{};
+    glGetProgramiv(this->m_program_id, GL_ACTIVE_UNIFORMS, &uniform_count);
+    glGetProgramiv(this->m_program_id, GL_ACTIVE_UNIFORM_MAX_LENGTH,
+        &max_name_length);
+
+    std::vector<char> name_buffer(
+        static_cast<std::size_t>(max_name_length) + 1);
+
+    for (GLint index{ 0 }; index < uniform_count; index++)
+    {
+        GLsizei length{};
+        GLint size{};
+        GLenum type{};
+        glGetActiveUniform(this->m_program_id, static_cast<GLuint>(index),
+            static_cast<GLsizei>(name_buffer.size()), &length, &size, &type,
+            name_buffer.data());
+
+        std::string name{ name_buffer.data(),
+            static_cast<std::size_t>(length) };
+
+        // Members of uniform blocks have no location of their own
+        GLint location{ glGetUniformLocation(this->m_program_id,
+            name.c_str()) };
+        if (location < 0)
+            continue;
+
+        this->m_uniform_locations.emplace(name, location);
+
+        constexpr std::string_view array_suffix{ "[0]" };
+        if (name.size() > array_suffix.size() &&
+            name.compare(name.size() - array_suffix.size(),
+                array_suffix.size(), array_suffix) == 0)
+            this->m_uniform_locations.emplace(
+                name.substr(0, name.size() - array_suffix.size()), location);
+    }
+}
+
 void ShaderProgram::activate_program() const noexcept
 {
+    this->finish_link();
     glUseProgram(this->m_program_id);
 }
 
-void ShaderProgram::set_bool(const std::string& uniform_name, GLboolean value)
-const noexcept
+// Looks a uniform up without allocating; unknown or inactive names give a
+// handle that refers to no uniform
+Uniform ShaderProgram::get_uniform(std::string_view uniform_name) const
+noexcept
 {
-    glUniform1i(glGetUniformLocation(this->m_program_id, uniform_name.c_str()),
-        static_cast<int>(value));
+    this->finish_link();
+
+    auto found{ this->m_uniform_locations.find(uniform_name) };
+    if (found == this->m_uniform_locations.end())
+        return Uniform{};
+
+    return Uniform{ found->second };
 }
 
-void ShaderProgram::set_int(const std::string& uniform_name, GLint value)
-const noexcept
+// Points a uniform block at a binding point; blocks the program does not use
+// are ignored
+void ShaderProgram::set_uniform_block_binding(std::string_view block_name,
+    GLuint binding) const noexcept
+{
+    this->finish_link();
+
+    std::string name{ block_name };
+    GLuint block_index{ glGetUniformBlockIndex(this->m_program_id,
+        name.c_str()) };
+
+    if (block_index != GL_INVALID_INDEX)
+        glUniformBlockBinding(this->m_program_id, block_index, binding);
+}
+
+void ShaderProgram::set_bool(Uniform uniform, GLboolean value) const noexcept
+{
+    glUniform1i(uniform.location, static_cast<int>(value));
+}
+
+void ShaderProgram::set_bool(std::string_view uniform_name,
+    GLboolean value) const noexcept
+{
+    this->set_bool(this->get_uniform(uniform_name), value);
+}
+
+void ShaderProgram::set_int(Uniform uniform, GLint value) const noexcept
+{
+    glUniform1i(uniform.location, value);
+}
+
+void ShaderProgram::set_int(std::string_view uniform_name,
+    GLint value) const noexcept
+{
+    this->set_int(this->get_uniform(uniform_name), value);
+}
+
+void ShaderProgram::set_float(Uniform uniform, GLfloat value) const noexcept
+{
+    glUniform1f(uniform.location, value);
+}
+
+void ShaderProgram::set_float(std::string_view uniform_name,
+    GLfloat value) const noexcept
 {
-    glUniform1i(glGetUniformLocation(this->m_program_id, uniform_name.c_str()),
-        value);
+    this->set_float(this->get_uniform(uniform_name), value);
 }
 
-void ShaderProgram::set_float(const std::string& uniform_name, GLfloat value)
+void ShaderProgram::set_vec1(Uniform uniform, const glm::vec1& value)
 const noexcept
 {
-    glUniform1f(glGetUniformLocation(this->m_program_id, uniform_name.c_str()),
-        value);
+    glUniform1fv(uniform.location, 1, &value[0]);
 }
 
-void ShaderProgram::set_vec1(const std::string& uniform_name,
+void ShaderProgram::set_vec1(std::string_view uniform_name,
     const glm::vec1& value) const noexcept
 {
-    glUniform1fv(glGetUniformLocation(this->m_program_id, uniform_name.c_str()),
-        1, &value[0]);
+    this->set_vec1(this->get_uniform(uniform_name), value);
+}
+
+void ShaderProgram::set_vec2(Uniform uniform, const glm::vec2& value)
+const noexcept
+{
+    glUniform2fv(uniform.location, 1, &value[0]);
 }
 
-void ShaderProgram::set_vec2(const std::string& uniform_name,
+void ShaderProgram::set_vec2(std::string_view uniform_name,
     const glm::vec2& value) const noexcept
 {
-    glUniform2fv(glGetUniformLocation(this->m_program_id, uniform_name.c_str()),
-        1, &value[0]);
+    this->set_vec2(this->get_uniform(uniform_name), value);
 }
 
-void ShaderProgram::set_vec3(const std::string& uniform_name,
+void ShaderProgram::set_vec3(Uniform uniform, const glm::vec3& value)
+const noexcept
+{
+    glUniform3fv(uniform.location, 1, &value[0]);
+}
+
+void ShaderProgram::set_vec3(std::string_view uniform_name,
     const glm::vec3& value) const noexcept
 {
-    glUniform3fv(glGetUniformLocation(this->m_program_id, uniform_name.c_str()),
-        1, &value[0]);
+    this->set_vec3(this->get_uniform(uniform_name), value);
+}
+
+void ShaderProgram::set_float_array(Uniform uniform,
+    const GLfloat* values, GLsizei count) const noexcept
+{
+    glUniform1fv(uniform.location, count, values);
+}
+
+void ShaderProgram::set_float_array(std::string_view uniform_name,
+    const GLfloat* values, GLsizei count) const noexcept
+{
+    this->set_float_array(this->get_uniform(uniform_name), values, count);
+}
+
+void ShaderProgram::set_vec3_array(Uniform uniform,
+    const glm::vec3* values, GLsizei count) const noexcept
+{
+    glUniform3fv(uniform.location, count, &values[0][0]);
+}
+
+void ShaderProgram::set_vec3_array(std::string_view uniform_name,
+    const glm::vec3* values, GLsizei count) const noexcept
+{
+    this->set_vec3_array(this->get_uniform(uniform_name), values, count);
+}
+
+void ShaderProgram::set_mat2(Uniform uniform, const glm::mat2& value)
+const noexcept
+{
+    glUniformMatrix2fv(uniform.location, 1, GL_FALSE, &value[0][0]);
 }
 
-void ShaderProgram::set_mat2(const std::string& uniform_name,
+void ShaderProgram::set_mat2(std::string_view uniform_name,
     const glm::mat2& value) const noexcept
 {
-    glUniformMatrix2fv(glGetUniformLocation(this->m_program_id,
-        uniform_name.c_str()),
-        1, GL_FALSE, &value[0][0]);
+    this->set_mat2(this->get_uniform(uniform_name), value);
+}
+
+void ShaderProgram::set_mat3(Uniform uniform, const glm::mat3& value)
+const noexcept
+{
+    glUniformMatrix3fv(uniform.location, 1, GL_FALSE, &value[0][0]);
 }
 
-void ShaderProgram::set_mat3(const std::string& uniform_name,
+void ShaderProgram::set_mat3(std::string_view uniform_name,
     const glm::mat3& value) const noexcept
 {
-    glUniformMatrix3fv(glGetUniformLocation(this->m_program_id,
-        uniform_name.c_str()),
-        1, GL_FALSE, &value[0][0]);
+    this->set_mat3(this->get_uniform(uniform_name), value);
+}
+
+void ShaderProgram::set_mat4(Uniform uniform, const glm::mat4& value)
+const noexcept
+{
+    glUniformMatrix4fv(uniform.location, 1, GL_FALSE, &value[0][0]);
 }
 
-void ShaderProgram::set_mat4(const std::string& uniform_name,
+void ShaderProgram::set_mat4(std::string_view uniform_name,
     const glm::mat4& value) const noexcept
 {
-    glUniformMatrix4fv(glGetUniformLocation(this->m_program_id,
-        uniform_name.c_str()),
-        1, GL_FALSE, &value[0][0]);
+    this->set_mat4(this->get_uniform(uniform_name), value);
 }
 
 GLuint ShaderProgram::get_program_id() const noexcept
 {
+    this->finish_link();
     return this->m_program_id;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+
+// Every specialization of one vertex and fragment shader pair that has been
+// asked for, each built the first time its set of defines is needed and kept
+// from then on. `setup` runs on every program when it is first handed out,
+// e.g. to bind its uniform blocks.
+class ShaderVariants
+{
+    using setup_function = void (*)(ShaderProgram&);
+
+    struct Variant
+    {
+        std::unique_ptr<ShaderProgram> program{};
+        bool set_up{ false };
+    };
+
+    std::string m_vertex_path{};
+    std::string m_fragment_path{};
+    setup_function m_setup{};
+    std::map<std::string, Variant, std::less<>> m_variants{};
+
+public:
+    ShaderVariants(std::string, std::string, setup_function = nullptr)
+        noexcept;
+
+    void prepare(const ShaderDefines&) noexcept;
+    ShaderProgram& get(const ShaderDefines&) noexcept;
+
+    std::unique_ptr<ShaderProgram> build(const ShaderDefines&) const noexcept;
+    void replace_all(const ShaderDefines&, std::unique_ptr<ShaderProgram>)
+        noexcept;
+
+    std::size_t size() const noexcept;
+};
+
+ShaderVariants::ShaderVariants(std::string vertex_path,
+    std::string fragment_path, setup_function setup) noexcept :
+    m_vertex_path{ std::move(vertex_path) },
+    m_fragment_path{ std::move(fragment_path) },
+    m_setup{ setup }
+{
+}
+
+// Issues the compile of a variant that is known to be needed soon without
+// waiting for it, so it can build alongside other work
+void ShaderVariants::prepare(const ShaderDefines& defines) noexcept
+{
+    std::string key{ make_define_block(defines) };
+    if (this->m_variants.find(key) == this->m_variants.end())
+        this->m_variants.emplace(std::move(key),
+            Variant{ this->build(defines) });
+}
+
+// The program for a set of defines, built on first use. Callers keep the
+// reference rather than asking again every frame, since the lookup builds
+// the define block.
+ShaderProgram& ShaderVariants::get(const ShaderDefines& defines) noexcept
+{
+    std::string key{ make_define_block(defines) };
+
+    auto found{ this->m_variants.find(key) };
+    if (found == this->m_variants.end())
+        found = this->m_variants.emplace(std::move(key),
+            Variant{ this->build(defines) }).first;
+
+    Variant& variant{ found->second };
+    if (!variant.set_up)
+    {
+        if (this->m_setup)
+            this->m_setup(*variant.program);
+        variant.set_up = true;
+    }
+
+    return *variant.program;
+}
+
+// A new program for a set of defines that is not added to the variants,
+// e.g. to be checked before it replaces the one in use
+std::unique_ptr<ShaderProgram> ShaderVariants::build(
+    const ShaderDefines& defines) const noexcept
+{
+    return std::make_unique<ShaderProgram>(this->m_vertex_path,
+        this->m_fragment_path, defines);
+}
+
+// Keeps only `program`, built for `defines` from sources that changed; the
+// other variants are built again from the new sources when they are needed
+void ShaderVariants::replace_all(const ShaderDefines& defines,
+    std::unique_ptr<ShaderProgram> program) noexcept
+{
+    this->m_variants.clear();
+    this->m_variants.emplace(make_define_block(defines),
+        Variant{ std::move(program) });
+}
+
+std::size_t ShaderVariants::size() const noexcept
+{
+    return this->m_variants.size();
+}
+
 #endif
\ No newline at end of file
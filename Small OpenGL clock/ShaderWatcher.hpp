@@ -0,0 +1,196 @@
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+
+#ifdef __linux__
+#  include <cerrno>
+#  include <climits>
+#  include <poll.h>
+#  include <sys/eventfd.h>
+#  include <sys/inotify.h>
+#  include <unistd.h>
+#endif
+
+#pragma once
+
+#ifndef SHADER_WATCHER_HPP
+#  define SHADER_WATCHER_HPP
+
+// Shader files whose changes are picked up while the clock runs: the dial
+// and the hands
+constexpr std::array<std::string_view, 2> watched_shader_prefixes{
+    "circle-", "triangle-" };
+
+bool is_watched_shader(std::string_view name) noexcept
+{
+    constexpr std::string_view extension{ ".glsl" };
+    if (name.size() <= extension.size() ||
+        name.substr(name.size() - extension.size()) != extension)
+        return false;
+
+    for (std::string_view prefix : watched_shader_prefixes)
+    {
+        if (name.substr(0, prefix.size()) == prefix)
+            return true;
+    }
+
+    return false;
+}
+
+// Watches a directory for shader files being written and tells the render
+// loop about it, so shaders can be tuned on a running clock.
+//
+// On Linux an inotify watch on the directory, rather than on every file, so
+// editors that save by writing a new file and renaming it over the old one
+// are noticed too. A small thread waits on it and calls a notify function
+// after every batch of changes, e.g. glfwPostEmptyEvent to wake the main loop.
+// Elsewhere start() fails and shaders are only loaded at startup.
+class ShaderWatcher
+{
+    using notify_function = std::function<void()>;
+
+    std::atomic<bool> m_changed{ false };
+    std::thread m_thread{};
+
+#ifdef __linux__
+    int m_inotify_fd{ -1 };
+    int m_stop_fd{ -1 };
+    notify_function m_notify{};
+
+    void run() noexcept;
+#endif
+
+public:
+    ShaderWatcher() noexcept = default;
+    ~ShaderWatcher() noexcept;
+
+    ShaderWatcher(const ShaderWatcher&) = delete;
+    ShaderWatcher& operator=(const ShaderWatcher&) = delete;
+
+    bool start(const std::string&, notify_function) noexcept;
+    void stop() noexcept;
+
+    bool take_changes() noexcept;
+};
+
+ShaderWatcher::~ShaderWatcher() noexcept
+{
+    this->stop();
+}
+
+#ifdef __linux__
+
+bool ShaderWatcher::start(const std::string& directory,
+    notify_function notify) noexcept
+{
+    if (this->m_thread.joinable())
+        return false;
+
+    this->m_notify = std::move(notify);
+
+    this->m_inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    this->m_stop_fd = eventfd(0, EFD_CLOEXEC);
+    if (this->m_inotify_fd < 0 || this->m_stop_fd < 0 ||
+        inotify_add_watch(this->m_inotify_fd, directory.c_str(),
+            IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+    {
+        this->stop();
+        return false;
+    }
+
+    this->m_thread = std::thread{ &ShaderWatcher::run, this };
+    return true;
+}
+
+void ShaderWatcher::stop() noexcept
+{
+    if (this->m_thread.joinable())
+    {
+        std::uint64_t one{ 1 };
+        [[maybe_unused]] ssize_t result{
+            write(this->m_stop_fd, &one, sizeof(one)) };
+        this->m_thread.join();
+    }
+
+    if (this->m_inotify_fd >= 0)
+        close(this->m_inotify_fd);
+    if (this->m_stop_fd >= 0)
+        close(this->m_stop_fd);
+
+    this->m_inotify_fd = -1;
+    this->m_stop_fd = -1;
+}
+
+void ShaderWatcher::run() noexcept
+{
+    pollfd fds[2]{ { this->m_inotify_fd, POLLIN, 0 },
+                   { this->m_stop_fd, POLLIN, 0 } };
+
+    alignas(inotify_event) char buffer[16 * (sizeof(inotify_event) +
+        NAME_MAX + 1)];
+
+    while (true)
+    {
+        if (poll(fds, 2, -1) < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return;
+        }
+
+        if (fds[1].revents & POLLIN)
+            return;
+
+        if (!(fds[0].revents & POLLIN))
+            continue;
+
+        bool changed{ false };
+        ssize_t length{};
+        while ((length = read(this->m_inotify_fd, buffer, sizeof(buffer))) > 0)
+        {
+            for (ssize_t offset{ 0 }; offset < length;)
+            {
+                const auto* event{
+                    reinterpret_cast<const inotify_event*>(buffer + offset) };
+                if (event->len > 0 && is_watched_shader(event->name))
+                    changed = true;
+
+                offset += static_cast<ssize_t>(sizeof(inotify_event)) +
+                    event->len;
+            }
+        }
+
+        if (!changed)
+            continue;
+
+        this->m_changed.store(true, std::memory_order_release);
+        if (this->m_notify)
+            this->m_notify();
+    }
+}
+
+#else
+
+bool ShaderWatcher::start(const std::string&, notify_function) noexcept
+{
+    return false;
+}
+
+void ShaderWatcher::stop() noexcept
+{
+}
+
+#endif
+
+// Whether a watched shader changed since the last call
+bool ShaderWatcher::take_changes() noexcept
+{
+    return this->m_changed.exchange(false, std::memory_order_acquire);
+}
+
+#endif
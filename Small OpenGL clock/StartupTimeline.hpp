@@ -0,0 +1,78 @@
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string_view>
+#include <vector>
+
+#pragma once
+
+#ifndef STARTUP_TIMELINE_HPP
+#  define STARTUP_TIMELINE_HPP
+
+// Wall-clock phases of starting up, measured from when the timeline was
+// created. Phases on the main thread follow each other through mark(), and
+// work on other threads is added with its own begin and end, so the printed
+// timeline shows what overlapped and what was on the critical path.
+class StartupTimeline
+{
+public:
+    using clock = std::chrono::steady_clock;
+
+private:
+    struct Phase
+    {
+        std::string_view name{};
+        clock::time_point begin{};
+        clock::time_point end{};
+    };
+
+    clock::time_point m_origin{ clock::now() };
+    clock::time_point m_last_mark{ m_origin };
+    std::vector<Phase> m_phases{};
+
+public:
+    void mark(std::string_view) noexcept;
+    void add(std::string_view, clock::time_point, clock::time_point) noexcept;
+
+    void print() const noexcept;
+};
+
+// Ends a main thread phase that started at the previous mark
+void StartupTimeline::mark(std::string_view name) noexcept
+{
+    clock::time_point now{ clock::now() };
+    this->m_phases.push_back(Phase{ name, this->m_last_mark, now });
+    this->m_last_mark = now;
+}
+
+void StartupTimeline::add(std::string_view name, clock::time_point begin,
+    clock::time_point end) noexcept
+{
+    this->m_phases.push_back(Phase{ name, begin, end });
+}
+
+void StartupTimeline::print() const noexcept
+{
+    auto to_ms = [this](clock::time_point time) {
+        return std::chrono::duration<double, std::milli>(
+            time - this->m_origin).count();
+    };
+
+    std::vector<Phase> phases{ this->m_phases };
+    std::stable_sort(phases.begin(), phases.end(),
+        [](const Phase& a, const Phase& b) { return a.begin < b.begin; });
+
+    std::ios::fmtflags flags{ std::cerr.flags() };
+    std::cerr << std::fixed << std::setprecision(1)
+              << "Startup:             start      end\n";
+    for (const Phase& phase : phases)
+    {
+        std::cerr << "  " << std::left << std::setw(16) << phase.name
+                  << std::right << std::setw(9) << to_ms(phase.begin)
+                  << std::setw(9) << to_ms(phase.end) << " ms\n";
+    }
+    std::cerr.flags(flags);
+}
+
+#endif
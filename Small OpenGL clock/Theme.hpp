@@ -0,0 +1,70 @@
+#include <array>
+#include <cstddef>
+#include <string_view>
+
+#include <glm/glm.hpp>
+
+#pragma once
+
+#ifndef THEME_HPP
+#  define THEME_HPP
+
+constexpr glm::vec3 hex2vec3(std::string_view hex);
+
+struct Theme
+{
+    std::string_view name{};
+    glm::vec3 clear_color{};
+    glm::vec3 circle_color{};
+
+    // Seconds, minutes and hours hand, in that order
+    std::array<glm::vec3, 3> hand_colors{};
+};
+
+// The colors can be replaced by the palette in the asset pack at startup
+std::array<Theme, 2> themes{
+    Theme{ "dark",
+           hex2vec3("1d2021"),
+           hex2vec3("fbf1c7"),
+           { hex2vec3("cc241d"), hex2vec3("8ec07c"), hex2vec3("fabd2f") } },
+    Theme{ "light",
+           hex2vec3("fbf1c7"),
+           hex2vec3("3c3836"),
+           { hex2vec3("9d0006"), hex2vec3("427b58"), hex2vec3("b57614") } }
+};
+
+constexpr glm::vec3 hex2vec3(std::string_view hex)
+{
+    auto to_int = [](char ch) {
+        switch (ch) {
+        case '0': return 0;
+        case '1': return 1;
+        case '2': return 2;
+        case '3': return 3;
+        case '4': return 4;
+        case '5': return 5;
+        case '6': return 6;
+        case '7': return 7;
+        case '8': return 8;
+        case '9': return 9;
+        case 'a': return 10;
+        case 'b': return 11;
+        case 'c': return 12;
+        case 'd': return 13;
+        case 'e': return 14;
+        case 'f': return 15;
+        default: return -1;
+        }
+    };
+
+    float red =
+        static_cast<float>((to_int(hex[0]) * 16) + to_int(hex[1])) / 255;
+    float green =
+        static_cast<float>((to_int(hex[2]) * 16) + to_int(hex[3])) / 255;
+    float blue =
+        static_cast<float>((to_int(hex[4]) * 16) + to_int(hex[5])) / 255;
+
+    return { red, green, blue };
+}
+
+#endif
@@ -0,0 +1,226 @@
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <mutex>
+
+#pragma once
+
+#ifndef TIME_SERVICE_HPP
+#  define TIME_SERVICE_HPP
+
+struct LocalTime
+{
+    std::int64_t utc_seconds{};
+    std::int32_t utc_offset{};
+
+    std::int32_t hour{};
+    std::int32_t minute{};
+    std::int32_t second{};
+
+    // Fraction of the current second, in [0, 1)
+    double subsecond{};
+};
+
+// Hands out the local time without calling std::localtime per frame.
+//
+// The UTC offset is looked up once and kept until the next DST transition or
+// an explicit invalidate() after a clock step; in between the time is derived
+// from the steady clock plus an anchor on the system clock. The anchor itself
+// is cheap to take and is refreshed every minute so that NTP slewing of the
+// system clock cannot make the two drift apart. snapshot() may be called from
+// any thread.
+class TimeService
+{
+public:
+    using steady_clock = std::chrono::steady_clock;
+    using system_clock = std::chrono::system_clock;
+
+private:
+    struct Anchor
+    {
+        steady_clock::time_point steady{};
+        std::int64_t utc_nanoseconds{};
+        std::int32_t utc_offset{};
+
+        steady_clock::time_point refresh_at{};
+        std::int64_t offset_valid_until{};
+    };
+
+    static constexpr std::chrono::seconds m_refresh_interval{ 60 };
+
+    // How far ahead a DST transition is searched for, and in which steps
+    static constexpr std::int64_t m_transition_horizon{ 400 * 86400 };
+    static constexpr std::int64_t m_transition_step{ 7 * 86400 };
+
+    mutable std::shared_ptr<const Anchor> m_anchor{};
+    mutable std::mutex m_recompute_mutex{};
+
+    std::shared_ptr<const Anchor> reanchor(const Anchor*) const noexcept;
+
+public:
+    TimeService() noexcept;
+
+    LocalTime snapshot() const noexcept;
+    void invalidate() noexcept;
+
+    static std::int32_t utc_offset_at(std::time_t) noexcept;
+    static std::int64_t next_offset_change(std::time_t) noexcept;
+};
+
+TimeService::TimeService() noexcept
+{
+    std::atomic_store(&this->m_anchor, this->reanchor(nullptr));
+}
+
+LocalTime TimeService::snapshot() const noexcept
+{
+    auto anchor{ std::atomic_load(&this->m_anchor) };
+    auto steady_now{ steady_clock::now() };
+
+    std::int64_t utc_nanoseconds{ anchor->utc_nanoseconds +
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            steady_now - anchor->steady).count() };
+
+    if (steady_now >= anchor->refresh_at ||
+        (utc_nanoseconds / 1'000'000'000) >= anchor->offset_valid_until)
+    {
+        std::lock_guard<std::mutex> lock{ this->m_recompute_mutex };
+
+        // Another thread may have done the work while we were waiting
+        auto current{ std::atomic_load(&this->m_anchor) };
+        if (current == anchor)
+        {
+            current = this->reanchor(anchor.get());
+            std::atomic_store(&this->m_anchor, current);
+        }
+
+        anchor = current;
+        utc_nanoseconds = anchor->utc_nanoseconds +
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                steady_now - anchor->steady).count();
+    }
+
+    // Floor division, so times before the epoch still split correctly
+    std::int64_t utc_seconds{ utc_nanoseconds / 1'000'000'000 };
+    std::int64_t nanoseconds{ utc_nanoseconds % 1'000'000'000 };
+    if (nanoseconds < 0)
+    {
+        utc_seconds--;
+        nanoseconds += 1'000'000'000;
+    }
+
+    std::int64_t seconds_of_day{ (utc_seconds + anchor->utc_offset) % 86400 };
+    if (seconds_of_day < 0)
+        seconds_of_day += 86400;
+
+    LocalTime result{};
+    result.utc_seconds = utc_seconds;
+    result.utc_offset = anchor->utc_offset;
+    result.hour = static_cast<std::int32_t>(seconds_of_day / 3600);
+    result.minute = static_cast<std::int32_t>((seconds_of_day / 60) % 60);
+    result.second = static_cast<std::int32_t>(seconds_of_day % 60);
+    result.subsecond = static_cast<double>(nanoseconds) / 1e9;
+
+    return result;
+}
+
+// Drops the cached offset and anchor, e.g. after the system clock was stepped
+void TimeService::invalidate() noexcept
+{
+    std::lock_guard<std::mutex> lock{ this->m_recompute_mutex };
+    std::atomic_store(&this->m_anchor, this->reanchor(nullptr));
+}
+
+// Takes a new anchor on the system clock. The UTC offset of the previous
+// anchor is kept as long as it is still valid, so the timezone database is
+// only consulted again at the next transition.
+std::shared_ptr<const TimeService::Anchor> TimeService::reanchor(
+    const Anchor* previous) const noexcept
+{
+    auto anchor{ std::make_shared<Anchor>() };
+    anchor->steady = steady_clock::now();
+    anchor->utc_nanoseconds =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            system_clock::now().time_since_epoch()).count();
+    anchor->refresh_at = anchor->steady + m_refresh_interval;
+
+    std::time_t now{ static_cast<std::time_t>(
+        anchor->utc_nanoseconds / 1'000'000'000) };
+
+    if (previous && now < previous->offset_valid_until)
+    {
+        anchor->utc_offset = previous->utc_offset;
+        anchor->offset_valid_until = previous->offset_valid_until;
+    }
+    else
+    {
+        anchor->utc_offset = utc_offset_at(now);
+        anchor->offset_valid_until = next_offset_change(now);
+    }
+
+    return anchor;
+}
+
+std::int32_t TimeService::utc_offset_at(std::time_t time) noexcept
+{
+    std::tm local{};
+#ifdef _WIN32
+    localtime_s(&local, &time);
+#else
+    localtime_r(&time, &local);
+#endif
+
+    // Days since the epoch for the civil date, from Howard Hinnant's
+    // days_from_civil, so that no second timezone lookup is needed
+    std::int64_t year{ local.tm_year + 1900 };
+    std::int64_t month{ local.tm_mon + 1 };
+    year -= month <= 2;
+    std::int64_t era{ (year >= 0 ? year : year - 399) / 400 };
+    std::int64_t year_of_era{ year - (era * 400) };
+    std::int64_t day_of_year{ ((153 * (month + (month > 2 ? -3 : 9))) + 2) / 5 +
+        local.tm_mday - 1 };
+    std::int64_t day_of_era{ (year_of_era * 365) + (year_of_era / 4) -
+        (year_of_era / 100) + day_of_year };
+    std::int64_t days{ (era * 146097) + day_of_era - 719468 };
+
+    std::int64_t local_seconds{ (days * 86400) + (local.tm_hour * 3600) +
+        (local.tm_min * 60) + local.tm_sec };
+
+    return static_cast<std::int32_t>(local_seconds - time);
+}
+
+// Finds the first second after `time` with a different UTC offset, by
+// stepping a week at a time and then bisecting. Returns the end of the search
+// horizon when there is no transition in it, which just causes a recheck.
+std::int64_t TimeService::next_offset_change(std::time_t time) noexcept
+{
+    std::int32_t offset{ utc_offset_at(time) };
+
+    std::int64_t low{ time };
+    std::int64_t high{ time };
+    while (high - time < m_transition_horizon)
+    {
+        high = low + m_transition_step;
+        if (utc_offset_at(static_cast<std::time_t>(high)) != offset)
+            break;
+        low = high;
+    }
+
+    if (utc_offset_at(static_cast<std::time_t>(high)) == offset)
+        return high;
+
+    while (high - low > 1)
+    {
+        std::int64_t middle{ low + ((high - low) / 2) };
+        if (utc_offset_at(static_cast<std::time_t>(middle)) == offset)
+            low = middle;
+        else
+            high = middle;
+    }
+
+    return high;
+}
+
+#endif
@@ -0,0 +1,633 @@
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#ifndef _WIN32
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+#pragma once
+
+#ifndef TIME_ZONE_HPP
+#  define TIME_ZONE_HPP
+
+// Transitions from the POSIX TZ rule at the end of a zone file are worked
+// out up front up to this year; after it the last offset simply stays
+constexpr std::int64_t zone_rule_last_year{ 2100 };
+
+// Days since 1970-01-01 for a date of the proleptic Gregorian calendar, from
+// Howard Hinnant's days_from_civil
+constexpr std::int64_t days_from_civil(std::int64_t year, std::int64_t month,
+    std::int64_t day) noexcept
+{
+    year -= month <= 2;
+    std::int64_t era{ (year >= 0 ? year : year - 399) / 400 };
+    std::int64_t year_of_era{ year - (era * 400) };
+    std::int64_t day_of_year{
+        (((153 * (month + (month > 2 ? -3 : 9))) + 2) / 5) + day - 1 };
+    std::int64_t day_of_era{ (year_of_era * 365) + (year_of_era / 4) -
+        (year_of_era / 100) + day_of_year };
+
+    return (era * 146097) + day_of_era - 719468;
+}
+
+constexpr bool is_leap_year(std::int64_t year) noexcept
+{
+    return (year % 4 == 0) && ((year % 100 != 0) || (year % 400 == 0));
+}
+
+// When a POSIX TZ rule switches to or from daylight saving time, as a day
+// of the year and a local time of day in seconds
+struct PosixTransitionRule
+{
+    enum class Kind
+    {
+        // Jn: day 1 to 365, February 29 is never counted
+        julian,
+        // n: day 0 to 365, counting February 29
+        day_of_year,
+        // Mm.w.d: day d (0 is Sunday) of week w (5 is the last) of month m
+        month_week_day
+    };
+
+    Kind kind{ Kind::month_week_day };
+    int day{};
+    int week{};
+    int month{};
+    std::int32_t time{ 2 * 3600 };
+
+    std::int64_t get_local_seconds(std::int64_t) const noexcept;
+};
+
+// Local seconds since the epoch at which the rule takes effect in `year`
+std::int64_t PosixTransitionRule::get_local_seconds(std::int64_t year) const
+noexcept
+{
+    std::int64_t days{};
+
+    switch (this->kind)
+    {
+    case Kind::julian:
+        days = days_from_civil(year, 1, 1) + this->day - 1 +
+            (is_leap_year(year) && this->day >= 60);
+        break;
+    case Kind::day_of_year:
+        days = days_from_civil(year, 1, 1) + this->day;
+        break;
+    case Kind::month_week_day:
+    {
+        constexpr int month_days[12]{
+            31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+        int days_in_month{ month_days[this->month - 1] +
+            (this->month == 2 && is_leap_year(year)) };
+
+        // 1970-01-01 was a Thursday
+        std::int64_t first{ days_from_civil(year, this->month, 1) };
+        int first_weekday{ static_cast<int>(((first % 7) + 11) % 7) };
+
+        int day_of_month{ 1 + ((this->day - first_weekday + 7) % 7) +
+            (7 * (this->week - 1)) };
+        while (day_of_month > days_in_month)
+            day_of_month -= 7;
+
+        days = first + day_of_month - 1;
+        break;
+    }
+    }
+
+    return (days * 86400) + this->time;
+}
+
+// The TZ string at the end of a version 2 zone file, like
+// "CET-1CEST,M3.5.0,M10.5.0/3", with its offsets as seconds east of UTC
+struct PosixZoneRule
+{
+    std::int32_t standard_offset{};
+    std::int32_t daylight_offset{};
+    bool has_daylight{ false };
+    PosixTransitionRule daylight_start{};
+    PosixTransitionRule daylight_end{};
+
+    bool parse(std::string_view) noexcept;
+};
+
+namespace posix_tz
+{
+    // Skips a zone abbreviation, either alphabetic or quoted in <>
+    bool skip_name(std::string_view& text) noexcept
+    {
+        std::size_t length{};
+        if (!text.empty() && text[0] == '<')
+        {
+            length = text.find('>');
+            if (length == std::string_view::npos)
+                return false;
+            length++;
+        }
+        else
+        {
+            while (length < text.size() &&
+                ((text[length] >= 'A' && text[length] <= 'Z') ||
+                 (text[length] >= 'a' && text[length] <= 'z')))
+                length++;
+            if (length < 3)
+                return false;
+        }
+
+        text.remove_prefix(length);
+        return true;
+    }
+
+    bool parse_number(std::string_view& text, int& value) noexcept
+    {
+        std::size_t length{};
+        value = 0;
+        while (length < text.size() && text[length] >= '0' &&
+            text[length] <= '9' && length < 4)
+        {
+            value = (value * 10) + (text[length] - '0');
+            length++;
+        }
+
+        text.remove_prefix(length);
+        return length > 0;
+    }
+
+    // [+-]hh[:mm[:ss]] in seconds
+    bool parse_time(std::string_view& text, std::int32_t& seconds) noexcept
+    {
+        bool negative{ !text.empty() && text[0] == '-' };
+        if (!text.empty() && (text[0] == '-' || text[0] == '+'))
+            text.remove_prefix(1);
+
+        int hours{}, minutes{}, rest{};
+        if (!parse_number(text, hours) || hours > 167)
+            return false;
+        if (!text.empty() && text[0] == ':')
+        {
+            text.remove_prefix(1);
+            if (!parse_number(text, minutes) || minutes > 59)
+                return false;
+            if (!text.empty() && text[0] == ':')
+            {
+                text.remove_prefix(1);
+                if (!parse_number(text, rest) || rest > 59)
+                    return false;
+            }
+        }
+
+        seconds = (hours * 3600) + (minutes * 60) + rest;
+        if (negative)
+            seconds = -seconds;
+        return true;
+    }
+
+    bool parse_rule(std::string_view& text,
+        PosixTransitionRule& rule) noexcept
+    {
+        using Kind = PosixTransitionRule::Kind;
+
+        if (!text.empty() && text[0] == 'M')
+        {
+            text.remove_prefix(1);
+            rule.kind = Kind::month_week_day;
+            if (!parse_number(text, rule.month) || rule.month < 1 ||
+                rule.month > 12 || text.empty() || text[0] != '.')
+                return false;
+            text.remove_prefix(1);
+            if (!parse_number(text, rule.week) || rule.week < 1 ||
+                rule.week > 5 || text.empty() || text[0] != '.')
+                return false;
+            text.remove_prefix(1);
+            if (!parse_number(text, rule.day) || rule.day > 6)
+                return false;
+        }
+        else if (!text.empty() && text[0] == 'J')
+        {
+            text.remove_prefix(1);
+            rule.kind = Kind::julian;
+            if (!parse_number(text, rule.day) || rule.day < 1 ||
+                rule.day > 365)
+                return false;
+        }
+        else
+        {
+            rule.kind = Kind::day_of_year;
+            if (!parse_number(text, rule.day) || rule.day > 365)
+                return false;
+        }
+
+        rule.time = 2 * 3600;
+        if (!text.empty() && text[0] == '/')
+        {
+            text.remove_prefix(1);
+            return parse_time(text, rule.time);
+        }
+
+        return true;
+    }
+}
+
+bool PosixZoneRule::parse(std::string_view text) noexcept
+{
+    // POSIX counts offsets west of UTC, the other way around from us
+    std::int32_t offset{};
+    if (!posix_tz::skip_name(text) || !posix_tz::parse_time(text, offset))
+        return false;
+
+    this->standard_offset = -offset;
+    this->has_daylight = !text.empty();
+    if (!this->has_daylight)
+        return true;
+
+    if (!posix_tz::skip_name(text))
+        return false;
+
+    this->daylight_offset = this->standard_offset + 3600;
+    if (!text.empty() && text[0] != ',')
+    {
+        if (!posix_tz::parse_time(text, offset))
+            return false;
+        this->daylight_offset = -offset;
+    }
+
+    // The US rules are the default when a zone names DST but no rule
+    if (text.empty())
+        text = ",M3.2.0,M11.1.0";
+
+    if (text[0] != ',')
+        return false;
+    text.remove_prefix(1);
+    if (!posix_tz::parse_rule(text, this->daylight_start) || text.empty() ||
+        text[0] != ',')
+        return false;
+    text.remove_prefix(1);
+
+    return posix_tz::parse_rule(text, this->daylight_end) && text.empty();
+}
+
+// The UTC offsets of one zone of the tz database as a table of the instants
+// they change at. Loading reads the zone file, version 2 and later with
+// 64-bit times and the POSIX TZ rule for the years after its last
+// transition, and merges transitions that do not change the offset, so all
+// that is left is one time and one offset per actual change.
+//
+// utc_offset_at() first checks the interval it returned last, which holds
+// for every lookup until the next transition, and only then does a binary
+// search. It makes no system calls and takes no lock, and may be called
+// from any thread once the zone is loaded.
+class TimeZone
+{
+    std::string m_name{};
+
+    // m_offsets[i] is in effect before m_transitions[i] and from
+    // m_transitions[i - 1] on, so there is one more offset than transitions
+    std::vector<std::int64_t> m_transitions{};
+    std::vector<std::int32_t> m_offsets{};
+
+    mutable std::atomic<std::size_t> m_cached_interval{ 0 };
+
+    void append(std::int64_t, std::int32_t) noexcept;
+    bool parse(std::string_view) noexcept;
+
+public:
+    TimeZone() noexcept = default;
+
+    TimeZone(const TimeZone&) = delete;
+    TimeZone& operator=(const TimeZone&) = delete;
+
+    bool load(const std::string&, const std::string&) noexcept;
+
+    std::int32_t utc_offset_at(std::int64_t) const noexcept;
+    std::int64_t next_transition(std::int64_t) const noexcept;
+
+    const std::string& get_name() const noexcept;
+    std::size_t get_transition_count() const noexcept;
+};
+
+namespace tzif
+{
+    std::int64_t read_big_endian(const unsigned char* data,
+        std::size_t size) noexcept
+    {
+        std::uint64_t value{};
+        for (std::size_t i{ 0 }; i < size; i++)
+            value = (value << 8) | data[i];
+
+        // Sign-extends 32-bit values
+        if (size == 4)
+            return static_cast<std::int32_t>(static_cast<std::uint32_t>(value));
+        return static_cast<std::int64_t>(value);
+    }
+
+    struct Header
+    {
+        char version{};
+        std::size_t utc_count{};
+        std::size_t standard_count{};
+        std::size_t leap_count{};
+        std::size_t time_count{};
+        std::size_t type_count{};
+        std::size_t char_count{};
+
+        bool read(std::string_view) noexcept;
+        std::size_t get_data_size(std::size_t) const noexcept;
+    };
+
+    constexpr std::size_t header_size{ 44 };
+
+    bool Header::read(std::string_view data) noexcept
+    {
+        if (data.size() < header_size || data.substr(0, 4) != "TZif")
+            return false;
+
+        const auto* bytes{ reinterpret_cast<const unsigned char*>(
+            data.data()) };
+        this->version = data[4];
+
+        std::size_t* counts[6]{ &this->utc_count, &this->standard_count,
+            &this->leap_count, &this->time_count, &this->type_count,
+            &this->char_count };
+        for (std::size_t i{ 0 }; i < 6; i++)
+            *counts[i] = static_cast<std::size_t>(static_cast<std::uint32_t>(
+                read_big_endian(bytes + 20 + (4 * i), 4)));
+
+        return this->type_count > 0;
+    }
+
+    // Size of the data block after the header, with times of `time_size`
+    // bytes
+    std::size_t Header::get_data_size(std::size_t time_size) const noexcept
+    {
+        return (this->time_count * (time_size + 1)) + (this->type_count * 6) +
+            this->char_count + (this->leap_count * (time_size + 4)) +
+            this->standard_count + this->utc_count;
+    }
+}
+
+// Adds a transition unless it comes before the last one or keeps the offset
+void TimeZone::append(std::int64_t time, std::int32_t offset) noexcept
+{
+    if (!this->m_transitions.empty() && time <= this->m_transitions.back())
+        return;
+    if (offset == this->m_offsets.back())
+        return;
+
+    this->m_transitions.push_back(time);
+    this->m_offsets.push_back(offset);
+}
+
+bool TimeZone::parse(std::string_view data) noexcept
+{
+    tzif::Header header{};
+    if (!header.read(data))
+        return false;
+
+    // Version 1 files only have 32-bit times; later ones repeat everything
+    // with 64-bit times after the first block, followed by the TZ rule
+    std::size_t time_size{ 4 };
+    if (header.version >= '2')
+    {
+        std::size_t second{ tzif::header_size + header.get_data_size(4) };
+        if (second > data.size() || !header.read(data.substr(second)))
+            return false;
+
+        data.remove_prefix(second);
+        time_size = 8;
+    }
+
+    std::size_t size{ tzif::header_size + header.get_data_size(time_size) };
+    if (size > data.size())
+        return false;
+
+    const auto* bytes{ reinterpret_cast<const unsigned char*>(data.data()) +
+        tzif::header_size };
+    const unsigned char* types{ bytes + (header.time_count * time_size) };
+    const unsigned char* type_infos{ types + header.time_count };
+
+    auto type_offset = [type_infos](std::size_t type) {
+        return static_cast<std::int32_t>(
+            tzif::read_big_endian(type_infos + (type * 6), 4));
+    };
+
+    // Before the first transition the first type applies
+    this->m_transitions.clear();
+    this->m_offsets.assign(1, type_offset(0));
+
+    for (std::size_t i{ 0 }; i < header.time_count; i++)
+    {
+        std::size_t type{ types[i] };
+        if (type >= header.type_count)
+            return false;
+
+        this->append(tzif::read_big_endian(bytes + (i * time_size),
+            time_size), type_offset(type));
+    }
+
+    // The footer is "\n<TZ rule>\n" and may be empty
+    std::string_view footer{ data.substr(size) };
+    if (time_size != 8 || footer.size() < 2 || footer[0] != '\n')
+        return true;
+
+    footer.remove_prefix(1);
+    footer = footer.substr(0, footer.find('\n'));
+
+    PosixZoneRule rule{};
+    if (footer.empty())
+        return true;
+    if (!rule.parse(footer))
+        return false;
+
+    // Without any transitions the rule covers all of time
+    std::int64_t last{ 0 };
+    if (this->m_transitions.empty())
+        this->m_offsets[0] = rule.standard_offset;
+    else
+        last = this->m_transitions.back();
+
+    if (!rule.has_daylight)
+    {
+        this->append(last + 1, rule.standard_offset);
+        return true;
+    }
+
+    // Starts a year early, since the estimate of the year the last
+    // transition is in may be off by one, and anything up to it is skipped
+    for (std::int64_t year{ 1970 + (last / 31'556'952) - 1 };
+        year <= zone_rule_last_year; year++)
+    {
+        std::pair<std::int64_t, std::int32_t> changes[2]{
+            { rule.daylight_start.get_local_seconds(year) -
+                rule.standard_offset, rule.daylight_offset },
+            { rule.daylight_end.get_local_seconds(year) -
+                rule.daylight_offset, rule.standard_offset } };
+
+        // Southern zones end daylight saving time before it starts again
+        if (changes[1].first < changes[0].first)
+            std::swap(changes[0], changes[1]);
+
+        for (const auto& [time, offset] : changes)
+            this->append(time, offset);
+    }
+
+    return true;
+}
+
+// Reads the zone `name`, like "Europe/Paris", from the tz database in
+// `directory`. The file is mapped only for as long as it takes to build the
+// table.
+bool TimeZone::load(const std::string& directory,
+    const std::string& name) noexcept
+{
+    this->m_name = name;
+    this->m_cached_interval.store(0, std::memory_order_relaxed);
+
+    if (name.empty() || name[0] == '/' ||
+        name.find("..") != std::string::npos)
+        return false;
+
+#ifdef _WIN32
+    static_cast<void>(directory);
+    return false;
+#else
+    std::string path{ directory + '/' + name };
+    int fd{ ::open(path.c_str(), O_RDONLY | O_CLOEXEC) };
+    if (fd < 0)
+        return false;
+
+    bool parsed{ false };
+    struct stat status{};
+    if (fstat(fd, &status) == 0 && S_ISREG(status.st_mode) &&
+        status.st_size > 0)
+    {
+        std::size_t size{ static_cast<std::size_t>(status.st_size) };
+        void* data{ mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0) };
+        if (data != MAP_FAILED)
+        {
+            parsed = this->parse(
+                std::string_view{ static_cast<const char*>(data), size });
+            munmap(data, size);
+        }
+    }
+    ::close(fd);
+
+    return parsed;
+#endif
+}
+
+// Seconds east of UTC in this zone at `utc_seconds` since the epoch
+std::int32_t TimeZone::utc_offset_at(std::int64_t utc_seconds) const noexcept
+{
+    const std::vector<std::int64_t>& transitions{ this->m_transitions };
+
+    std::size_t interval{
+        this->m_cached_interval.load(std::memory_order_relaxed) };
+    if ((interval == 0 || transitions[interval - 1] <= utc_seconds) &&
+        (interval == transitions.size() || utc_seconds < transitions[interval]))
+        return this->m_offsets[interval];
+
+    interval = static_cast<std::size_t>(std::upper_bound(transitions.begin(),
+        transitions.end(), utc_seconds) - transitions.begin());
+    this->m_cached_interval.store(interval, std::memory_order_relaxed);
+
+    return this->m_offsets[interval];
+}
+
+// The first instant after `utc_seconds` at which the offset changes, or the
+// largest time there is when it never does again
+std::int64_t TimeZone::next_transition(std::int64_t utc_seconds) const
+noexcept
+{
+    auto next{ std::upper_bound(this->m_transitions.begin(),
+        this->m_transitions.end(), utc_seconds) };
+
+    return next == this->m_transitions.end() ?
+        std::numeric_limits<std::int64_t>::max() : *next;
+}
+
+const std::string& TimeZone::get_name() const noexcept
+{
+    return this->m_name;
+}
+
+std::size_t TimeZone::get_transition_count() const noexcept
+{
+    return this->m_transitions.size();
+}
+
+// Every zone loaded so far, by name, so each zone file is read once however
+// many clocks show it. Loading is meant for startup on one thread; the zones
+// it hands out stay where they are and can be used from any thread.
+class ZoneDatabase
+{
+    std::string m_directory{};
+    std::map<std::string, std::unique_ptr<TimeZone>, std::less<>> m_zones{};
+
+public:
+    ZoneDatabase() noexcept;
+
+    void set_directory(std::string) noexcept;
+    const std::string& get_directory() const noexcept;
+
+    const TimeZone* load(std::string_view) noexcept;
+    std::size_t size() const noexcept;
+};
+
+// The database is where TZDIR points, like for the C library, and in the
+// usual place otherwise
+ZoneDatabase::ZoneDatabase() noexcept
+{
+    const char* directory{ std::getenv("TZDIR") };
+    this->m_directory = directory && *directory ? directory :
+        "/usr/share/zoneinfo";
+}
+
+void ZoneDatabase::set_directory(std::string directory) noexcept
+{
+    this->m_directory = std::move(directory);
+}
+
+const std::string& ZoneDatabase::get_directory() const noexcept
+{
+    return this->m_directory;
+}
+
+// The zone of that name, loaded on first use; nullptr when there is no such
+// zone or its file is not a valid zone file
+const TimeZone* ZoneDatabase::load(std::string_view name) noexcept
+{
+    auto found{ this->m_zones.find(name) };
+    if (found != this->m_zones.end())
+        return found->second.get();
+
+    auto zone{ std::make_unique<TimeZone>() };
+    if (!zone->load(this->m_directory, std::string{ name }))
+        return nullptr;
+
+    const TimeZone* result{ zone.get() };
+    this->m_zones.emplace(std::string{ name }, std::move(zone));
+    return result;
+}
+
+std::size_t ZoneDatabase::size() const noexcept
+{
+    return this->m_zones.size();
+}
+
+// Shared by everything showing the time somewhere else than the local zone
+ZoneDatabase zone_database{};
+
+#endif
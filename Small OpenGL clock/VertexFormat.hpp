@@ -0,0 +1,56 @@
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <vector>
+
+#pragma once
+
+#ifndef VERTEX_FORMAT_HPP
+#  define VERTEX_FORMAT_HPP
+
+// One attribute as it is stored in a vertex buffer. Normalized integers are
+// read by the shader as floats in [-1, 1] or [0, 1], so positions and
+// fractions need no more than 16 bits.
+struct VertexAttribute
+{
+    GLuint location{};
+    GLint components{};
+    GLenum type{ GL_FLOAT };
+    GLboolean normalized{ GL_FALSE };
+    std::size_t offset{};
+};
+
+// The layout of the vertices, or instances, in one buffer. apply() points
+// the attributes of the bound VAO at the bound GL_ARRAY_BUFFER, starting
+// `base` bytes into it, so all glVertexAttribPointer calls come from here.
+struct VertexFormat
+{
+    std::vector<VertexAttribute> attributes{};
+    GLsizei stride{};
+
+    void apply(GLuint = 0, std::size_t = 0) const noexcept;
+};
+
+// A divisor of 0 advances the attributes every vertex; any other advances
+// them every that many instances
+void VertexFormat::apply(GLuint divisor, std::size_t base) const noexcept
+{
+    for (const VertexAttribute& attribute : this->attributes)
+    {
+        glEnableVertexAttribArray(attribute.location);
+        glVertexAttribPointer(attribute.location, attribute.components,
+            attribute.type, attribute.normalized, this->stride,
+            (void*)(base + attribute.offset));
+        glVertexAttribDivisor(attribute.location, divisor);
+    }
+}
+
+// A value in [-1, 1] as a normalized GL_SHORT, rounded to nearest
+constexpr GLshort to_snorm16(float value) noexcept
+{
+    value = value < -1.0f ? -1.0f : (value > 1.0f ? 1.0f : value);
+    return static_cast<GLshort>(
+        (value * 32767.0f) + (value < 0.0f ? -0.5f : 0.5f));
+}
+
+#endif
@@ -0,0 +1,207 @@
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include <utility>
+
+#ifdef __linux__
+#  include <cerrno>
+#  include <ctime>
+#  include <poll.h>
+#  include <sys/eventfd.h>
+#  include <sys/timerfd.h>
+#  include <unistd.h>
+#endif
+
+#pragma once
+
+#ifndef WAKEUP_SOURCE_HPP
+#  define WAKEUP_SOURCE_HPP
+
+// Wakes the main loop exactly on the wall-clock grid for a given period, e.g.
+// whenever tm_sec changes, and reports when the system clock gets stepped.
+//
+// On Linux this is a CLOCK_REALTIME timerfd armed with an absolute deadline
+// and TFD_TIMER_CANCEL_ON_SET, waited on by a small thread that calls a
+// notify function on every expiry, e.g. one ending in glfwPostEmptyEvent so
+// the main loop can sleep in glfwWaitEvents and still handle input the moment
+// it arrives. Elsewhere start() fails and the caller falls back to timed
+// waits.
+class WakeupSource
+{
+    using notify_function = std::function<void()>;
+
+    std::atomic<bool> m_clock_stepped{ false };
+    std::atomic<std::uint64_t> m_ticks{};
+    std::thread m_thread{};
+
+#ifdef __linux__
+    int m_timer_fd{ -1 };
+    int m_stop_fd{ -1 };
+    std::chrono::nanoseconds m_period{};
+    notify_function m_notify{};
+
+    bool arm() noexcept;
+    void run() noexcept;
+#endif
+
+public:
+    WakeupSource() noexcept = default;
+    ~WakeupSource() noexcept;
+
+    WakeupSource(const WakeupSource&) = delete;
+    WakeupSource& operator=(const WakeupSource&) = delete;
+
+    bool start(std::chrono::nanoseconds, notify_function) noexcept;
+    void stop() noexcept;
+
+    bool is_running() const noexcept;
+    std::uint64_t get_ticks() const noexcept;
+    bool take_clock_step() noexcept;
+};
+
+WakeupSource::~WakeupSource() noexcept
+{
+    this->stop();
+}
+
+#ifdef __linux__
+
+bool WakeupSource::start(std::chrono::nanoseconds period,
+    notify_function notify) noexcept
+{
+    if (this->is_running() || period.count() <= 0)
+        return false;
+
+    this->m_period = period;
+    this->m_notify = std::move(notify);
+
+    this->m_timer_fd = timerfd_create(CLOCK_REALTIME, TFD_CLOEXEC);
+    this->m_stop_fd = eventfd(0, EFD_CLOEXEC);
+    if (this->m_timer_fd < 0 || this->m_stop_fd < 0 || !this->arm())
+    {
+        this->stop();
+        return false;
+    }
+
+    this->m_thread = std::thread{ &WakeupSource::run, this };
+    return true;
+}
+
+void WakeupSource::stop() noexcept
+{
+    if (this->m_thread.joinable())
+    {
+        std::uint64_t one{ 1 };
+        [[maybe_unused]] ssize_t result{
+            write(this->m_stop_fd, &one, sizeof(one)) };
+        this->m_thread.join();
+    }
+
+    if (this->m_timer_fd >= 0)
+        close(this->m_timer_fd);
+    if (this->m_stop_fd >= 0)
+        close(this->m_stop_fd);
+
+    this->m_timer_fd = -1;
+    this->m_stop_fd = -1;
+}
+
+bool WakeupSource::is_running() const noexcept
+{
+    return this->m_thread.joinable();
+}
+
+// Arms the timer for the next multiple of the period on the realtime clock;
+// the interval keeps it on that grid without ever rearming
+bool WakeupSource::arm() noexcept
+{
+    timespec now{};
+    clock_gettime(CLOCK_REALTIME, &now);
+
+    std::int64_t period_ns{ this->m_period.count() };
+    std::int64_t now_ns{ (static_cast<std::int64_t>(now.tv_sec) *
+        1'000'000'000) + now.tv_nsec };
+    std::int64_t next_ns{ ((now_ns / period_ns) + 1) * period_ns };
+
+    itimerspec spec{};
+    spec.it_value.tv_sec = static_cast<time_t>(next_ns / 1'000'000'000);
+    spec.it_value.tv_nsec = static_cast<long>(next_ns % 1'000'000'000);
+    spec.it_interval.tv_sec = static_cast<time_t>(period_ns / 1'000'000'000);
+    spec.it_interval.tv_nsec = static_cast<long>(period_ns % 1'000'000'000);
+
+    return timerfd_settime(this->m_timer_fd,
+        TFD_TIMER_ABSTIME | TFD_TIMER_CANCEL_ON_SET, &spec, nullptr) == 0;
+}
+
+void WakeupSource::run() noexcept
+{
+    pollfd fds[2]{ { this->m_timer_fd, POLLIN, 0 },
+                   { this->m_stop_fd, POLLIN, 0 } };
+
+    while (true)
+    {
+        if (poll(fds, 2, -1) < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return;
+        }
+
+        if (fds[1].revents & POLLIN)
+            return;
+
+        if (!(fds[0].revents & POLLIN))
+            continue;
+
+        std::uint64_t expirations{};
+        if (read(this->m_timer_fd, &expirations, sizeof(expirations)) < 0)
+        {
+            if (errno != ECANCELED)
+                continue;
+
+            // The clock was stepped, which also disarms the timer
+            this->m_clock_stepped.store(true, std::memory_order_release);
+            if (!this->arm())
+                return;
+        }
+        else
+        {
+            this->m_ticks.fetch_add(expirations, std::memory_order_relaxed);
+        }
+
+        if (this->m_notify)
+            this->m_notify();
+    }
+}
+
+#else
+
+bool WakeupSource::start(std::chrono::nanoseconds, notify_function) noexcept
+{
+    return false;
+}
+
+void WakeupSource::stop() noexcept
+{
+}
+
+bool WakeupSource::is_running() const noexcept
+{
+    return false;
+}
+
+#endif
+
+std::uint64_t WakeupSource::get_ticks() const noexcept
+{
+    return this->m_ticks.load(std::memory_order_relaxed);
+}
+
+bool WakeupSource::take_clock_step() noexcept
+{
+    return this->m_clock_stepped.exchange(false, std::memory_order_acquire);
+}
+
+#endif
@@ -0,0 +1,265 @@
+#include <cstddef>
+#include <cstdint>
+
+// SSE2 is part of every x86-64 CPU, and 32-bit builds have to enable it
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  define WALL_ANGLES_X86
+#  include <immintrin.h>
+#  ifdef _MSC_VER
+#    include <intrin.h>
+#  endif
+#endif
+
+// GCC and Clang only emit AVX2 in functions marked for it; MSVC always does
+#if defined(__GNUC__) || defined(__clang__)
+#  define WALL_ANGLES_AVX2_TARGET __attribute__((target("avx2")))
+#else
+#  define WALL_ANGLES_AVX2_TARGET
+#endif
+
+#pragma once
+
+#ifndef WALL_ANGLES_HPP
+#  define WALL_ANGLES_HPP
+
+// Where the hand angles of a batch of clocks go, one array per hand. Angles
+// are fractions of a full turn clockwise from 12 o'clock in 16 bits, 0 to
+// 65535, as the GL reads a normalized GL_UNSIGNED_SHORT.
+struct WallAngleArrays
+{
+    std::uint16_t* second_turns{};
+    std::uint16_t* minute_turns{};
+    std::uint16_t* hour_turns{};
+};
+
+using wall_angles_function = void (*)(std::int32_t, float,
+    const std::int32_t*, std::size_t, const WallAngleArrays&) noexcept;
+
+namespace wall_angles
+{
+    constexpr float periods[3]{ 60.0f, 3600.0f, 43200.0f };
+    constexpr float inverse_periods[3]{
+        1.0f / 60.0f, 1.0f / 3600.0f, 1.0f / 43200.0f };
+    constexpr float steps_per_second[3]{
+        65535.0f / 60.0f, 65535.0f / 3600.0f, 65535.0f / 43200.0f };
+
+    std::uint16_t hand_turns(float day_seconds, float subsecond,
+        std::size_t hand) noexcept
+    {
+        float quotient{ static_cast<float>(static_cast<std::int32_t>(
+            day_seconds * inverse_periods[hand])) };
+        float remainder{ day_seconds - (quotient * periods[hand]) };
+        if (remainder < 0.0f)
+            remainder += periods[hand];
+        if (remainder >= periods[hand])
+            remainder -= periods[hand];
+
+        // Rounded to nearest; a full turn is as good as none
+        return static_cast<std::uint16_t>(static_cast<std::int32_t>(
+            ((remainder + subsecond) * steps_per_second[hand]) + 0.5f));
+    }
+}
+
+// The arguments every version of the kernel takes: the UTC time of day in
+// whole seconds, the fraction of the current second, and the UTC offset of
+// every clock. Offsets are whole seconds, so only the time of day matters
+// and the fraction is the same for all clocks.
+//
+// All versions compute the same, bit for bit: the local time of day of each
+// clock is exact in 32-bit integers and floats, every hand is reduced to
+// its period without rounding, and only then is the fraction added and the
+// result rounded to 16 bits. Vector lanes cannot divide integers, so the
+// remainder comes from a float quotient, which can be one off, and is
+// corrected.
+void compute_wall_angles_scalar(std::int32_t day_seconds, float subsecond,
+    const std::int32_t* utc_offsets, std::size_t count,
+    const WallAngleArrays& angles) noexcept
+{
+    for (std::size_t i{ 0 }; i < count; i++)
+    {
+        std::int32_t local{ day_seconds + utc_offsets[i] };
+        if (local < 0)
+            local += 86400;
+        if (local >= 86400)
+            local -= 86400;
+
+        float seconds{ static_cast<float>(local) };
+        angles.second_turns[i] =
+            wall_angles::hand_turns(seconds, subsecond, 0);
+        angles.minute_turns[i] =
+            wall_angles::hand_turns(seconds, subsecond, 1);
+        angles.hour_turns[i] =
+            wall_angles::hand_turns(seconds, subsecond, 2);
+    }
+}
+
+#ifdef WALL_ANGLES_X86
+
+// Packs eight 32-bit lanes from 0 to 65535 into 16 bits. SSE2 only packs
+// with signed saturation, so the values are shifted into the signed range
+// and back.
+__m128i pack_wall_turns(__m128i low, __m128i high) noexcept
+{
+    const __m128i bias{ _mm_set1_epi32(32768) };
+    __m128i packed{ _mm_packs_epi32(_mm_sub_epi32(low, bias),
+        _mm_sub_epi32(high, bias)) };
+    return _mm_xor_si128(packed, _mm_set1_epi16(-32768));
+}
+
+// Four clocks at a time
+void compute_wall_angles_sse2(std::int32_t day_seconds, float subsecond,
+    const std::int32_t* utc_offsets, std::size_t count,
+    const WallAngleArrays& angles) noexcept
+{
+    const __m128i day{ _mm_set1_epi32(day_seconds) };
+    const __m128i day_length{ _mm_set1_epi32(86400) };
+    const __m128i last_second{ _mm_set1_epi32(86399) };
+    const __m128 fraction{ _mm_set1_ps(subsecond) };
+    const __m128 zero{ _mm_setzero_ps() };
+    const __m128 half{ _mm_set1_ps(0.5f) };
+    std::uint16_t* outputs[3]{ angles.second_turns, angles.minute_turns,
+        angles.hour_turns };
+
+    std::size_t i{ 0 };
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i local{ _mm_add_epi32(day, _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(utc_offsets + i))) };
+        local = _mm_add_epi32(local, _mm_and_si128(
+            _mm_cmplt_epi32(local, _mm_setzero_si128()), day_length));
+        local = _mm_sub_epi32(local, _mm_and_si128(
+            _mm_cmpgt_epi32(local, last_second), day_length));
+
+        __m128 seconds{ _mm_cvtepi32_ps(local) };
+        for (std::size_t hand{ 0 }; hand < 3; hand++)
+        {
+            const __m128 period{ _mm_set1_ps(wall_angles::periods[hand]) };
+
+            __m128 quotient{ _mm_cvtepi32_ps(_mm_cvttps_epi32(_mm_mul_ps(
+                seconds, _mm_set1_ps(wall_angles::inverse_periods[hand])))) };
+            __m128 remainder{ _mm_sub_ps(seconds,
+                _mm_mul_ps(quotient, period)) };
+            remainder = _mm_add_ps(remainder, _mm_and_ps(
+                _mm_cmplt_ps(remainder, zero), period));
+            remainder = _mm_sub_ps(remainder, _mm_and_ps(
+                _mm_cmpge_ps(remainder, period), period));
+
+            __m128i steps{ _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(
+                _mm_add_ps(remainder, fraction),
+                _mm_set1_ps(wall_angles::steps_per_second[hand])), half)) };
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(outputs[hand] + i),
+                pack_wall_turns(steps, steps));
+        }
+    }
+
+    WallAngleArrays rest{ angles.second_turns + i,
+        angles.minute_turns + i, angles.hour_turns + i };
+    compute_wall_angles_scalar(day_seconds, subsecond, utc_offsets + i,
+        count - i, rest);
+}
+
+// Eight clocks at a time, for CPUs that have AVX2
+WALL_ANGLES_AVX2_TARGET
+void compute_wall_angles_avx2(std::int32_t day_seconds, float subsecond,
+    const std::int32_t* utc_offsets, std::size_t count,
+    const WallAngleArrays& angles) noexcept
+{
+    const __m256i day{ _mm256_set1_epi32(day_seconds) };
+    const __m256i day_length{ _mm256_set1_epi32(86400) };
+    const __m256i last_second{ _mm256_set1_epi32(86399) };
+    const __m256 fraction{ _mm256_set1_ps(subsecond) };
+    const __m256 zero{ _mm256_setzero_ps() };
+    const __m256 half{ _mm256_set1_ps(0.5f) };
+    std::uint16_t* outputs[3]{ angles.second_turns, angles.minute_turns,
+        angles.hour_turns };
+
+    std::size_t i{ 0 };
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256i local{ _mm256_add_epi32(day, _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(utc_offsets + i))) };
+        local = _mm256_add_epi32(local, _mm256_and_si256(
+            _mm256_cmpgt_epi32(_mm256_setzero_si256(), local), day_length));
+        local = _mm256_sub_epi32(local, _mm256_and_si256(
+            _mm256_cmpgt_epi32(local, last_second), day_length));
+
+        __m256 seconds{ _mm256_cvtepi32_ps(local) };
+        for (std::size_t hand{ 0 }; hand < 3; hand++)
+        {
+            const __m256 period{
+                _mm256_set1_ps(wall_angles::periods[hand]) };
+
+            __m256 quotient{ _mm256_cvtepi32_ps(_mm256_cvttps_epi32(
+                _mm256_mul_ps(seconds,
+                    _mm256_set1_ps(wall_angles::inverse_periods[hand])))) };
+            __m256 remainder{ _mm256_sub_ps(seconds,
+                _mm256_mul_ps(quotient, period)) };
+            remainder = _mm256_add_ps(remainder, _mm256_and_ps(
+                _mm256_cmp_ps(remainder, zero, _CMP_LT_OQ), period));
+            remainder = _mm256_sub_ps(remainder, _mm256_and_ps(
+                _mm256_cmp_ps(remainder, period, _CMP_GE_OQ), period));
+
+            __m256i steps{ _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(
+                _mm256_add_ps(remainder, fraction),
+                _mm256_set1_ps(wall_angles::steps_per_second[hand])), half)) };
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(outputs[hand] + i),
+                pack_wall_turns(_mm256_castsi256_si128(steps),
+                    _mm256_extracti128_si256(steps, 1)));
+        }
+    }
+
+    WallAngleArrays rest{ angles.second_turns + i,
+        angles.minute_turns + i, angles.hour_turns + i };
+    compute_wall_angles_scalar(day_seconds, subsecond, utc_offsets + i,
+        count - i, rest);
+}
+
+bool cpu_has_avx2() noexcept
+{
+#  ifdef _MSC_VER
+    int registers[4]{};
+    __cpuid(registers, 0);
+    if (registers[0] < 7)
+        return false;
+
+    // AVX2 also needs the OS to save the YMM registers
+    __cpuid(registers, 1);
+    bool os_saves_ymm{ (registers[2] & (1 << 27)) &&
+        (_xgetbv(0) & 0x6) == 0x6 };
+    __cpuidex(registers, 7, 0);
+    return os_saves_ymm && (registers[1] & (1 << 5));
+#  else
+    return __builtin_cpu_supports("avx2");
+#  endif
+}
+
+#endif
+
+// The fastest version of the kernel this CPU runs, picked once
+wall_angles_function get_wall_angles_function() noexcept
+{
+#ifdef WALL_ANGLES_X86
+    static const wall_angles_function function{ cpu_has_avx2() ?
+        compute_wall_angles_avx2 : compute_wall_angles_sse2 };
+    return function;
+#else
+    return compute_wall_angles_scalar;
+#endif
+}
+
+// Hand angles of every clock at `utc_seconds` plus `subsecond`, for clocks
+// `utc_offsets` seconds east of UTC
+void compute_wall_angles(std::int64_t utc_seconds, float subsecond,
+    const std::int32_t* utc_offsets, std::size_t count,
+    const WallAngleArrays& angles) noexcept
+{
+    std::int64_t day_seconds{ utc_seconds % 86400 };
+    if (day_seconds < 0)
+        day_seconds += 86400;
+
+    get_wall_angles_function()(static_cast<std::int32_t>(day_seconds),
+        subsecond, utc_offsets, count, angles);
+}
+
+#endif
@@ -2,88 +2,119 @@
 
 in vec3 frag_pos;
 
-uniform vec3 circle_color;
-uniform float radius;
-uniform float line_length;
+// Shared by every clock program and filled from ClockState in
+// ClockRenderer.hpp, so the two have to be changed together
+layout (std140) uniform ClockState
+{
+    mat4 model;
+    vec3 circle_color;
+    float rim_thickness;
+    vec3 hand_color[3];
+    vec4 hand_length;
+    float radius;
+    float line_length;
+    int hour_ticks;
+    int minute_ticks;
+
+    // Set when there is no multisampling: shaders then output premultiplied
+    // color scaled by how much of the pixel they cover
+    int analytic_aa;
+
+    // The only part updated every frame: the local time of day in whole
+    // seconds and the fraction of the current second, kept apart so float
+    // precision does not limit how smoothly the hands sweep
+    vec2 time_of_day;
+};
+
+// Settings the program can be specialized for with #defines injected after
+// the #version line (see ShaderVariants in ShaderClass.hpp). Left undefined,
+// they are read from ClockState at runtime.
+#ifndef HOUR_TICKS
+#  define HOUR_TICKS hour_ticks
+#endif
+#ifndef MINUTE_TICKS
+#  define MINUTE_TICKS minute_ticks
+#endif
+#ifndef ANALYTIC_AA
+#  define ANALYTIC_AA (analytic_aa != 0)
+#endif
 
 out vec4 frag_result;
 
+const float pi = 3.14159265f;
+
+// Half widths of the tick marks and the length of the minute ticks. The dial
+// ring mesh in ClockRenderer.hpp is sized from the same values.
+const float hour_tick_width = 0.005f;
+const float minute_tick_width = 0.0025f;
+const float minute_tick_length = 0.05f;
+
+// Width of the dimmer band around every edge
+const float edge_width = 0.005f;
+
+// Distance from p, given in polar coordinates with the angle measured
+// clockwise from 12 o'clock, to the nearest of `count` evenly spaced radial
+// ticks that run from `inner` out to the rim. Folding the angle into one
+// sector keeps the cost the same for any number of ticks.
+float tick_distance(float r, float angle, int count, float inner, float width)
+{
+    if (count <= 0)
+        return 1e6f;
+
+    float sector = (2.0f * pi) / float(count);
+    float local = mod(angle + (0.5f * sector), sector) - (0.5f * sector);
+
+    // Arc length stands in for the distance across the tick; the two only
+    // differ noticeably far away from it, where nothing is drawn anyway
+    float across = r * abs(local);
+    float outside = max(max(inner - r, r - radius), 0.0f);
+
+    return length(vec2(across, outside)) - width;
+}
+
 void main()
 {
-    float S1 = dot(frag_pos, frag_pos) - (radius * radius);
-    float dist_origin = dot(frag_pos, frag_pos);
+    vec2 p = frag_pos.xy;
+    float r = length(p);
+
+    // Size of a pixel in dial units, taken before anything is discarded so
+    // the derivatives are still defined
+    float pixel_size = length(fwidth(p)) * 0.7071f;
+    float margin = max(edge_width, pixel_size);
 
-    // I hardcoded the values of tan(30), tan(60), -tan(30) and -tan(60) to save
-    // cycles on the GPU
+    // Everything is drawn in the ring between the inner end of the ticks and
+    // the outside of the rim, which leaves the rest to skip early
+    float inner = min(line_length, radius - minute_tick_length) -
+        hour_tick_width;
+    float outer = radius + max(0.5f * rim_thickness, hour_tick_width);
+    if (r < inner - margin || r > outer + margin)
+        discard;
+
+    float angle = atan(p.x, p.y);
 
-    // AA like thing
-    if ((0.008f < S1) && (S1 < 0.02f))
+    float d = abs(r - radius) - (0.5f * rim_thickness);
+    d = min(d, tick_distance(r, angle, HOUR_TICKS, line_length,
+        hour_tick_width));
+    d = min(d, tick_distance(r, angle, MINUTE_TICKS,
+        radius - minute_tick_length, minute_tick_width));
+
+    if (ANALYTIC_AA)
     {
-        frag_result = vec4(circle_color * 0.6f, 0.3f);
-        return;
+        // Coverage of a pixel-wide box filter centered on the fragment, with
+        // the edge moved out to the middle of the dimmer band so the strokes
+        // keep the weight they have with multisampling
+        d -= 0.5f * edge_width;
+        float coverage = clamp(0.5f - (d / pixel_size), 0.0f, 1.0f);
+        if (coverage <= 0.0f)
+            discard;
+
+        frag_result = vec4(circle_color * coverage, coverage);
     }
-    // Circle shading within tolerance
-    else if ((-0.008f < S1) && (S1 <= 0.008f))
-    {
+    else if (d <= 0.0f)
         frag_result = vec4(circle_color, 1.0f);
-        return;
-    }
-    // AA like thing
-    else if ((-0.02f < S1) && (S1 <= -0.008f))
-    {
+    // AA like thing, as in the old dial
+    else if (d < edge_width)
         frag_result = vec4(circle_color * 0.6f, 0.3f);
-    }
-    // Checking if the fragment is far enough away from the origin to form line
-    // but it also needs to be constrained inside the circle
-    else if (((line_length * line_length) < dist_origin) &&
-              (dist_origin < (radius * radius)))
-    {
-        float slope = -1.0f;
-        if (frag_pos.x != 0)
-            slope = frag_pos.y / frag_pos.x;
-
-        // Numbers 12, 3, 6, 9
-        if ((-0.005f < frag_pos.y && frag_pos.y < 0.005f) ||
-            (-0.005f < frag_pos.x && frag_pos.x < 0.005f))
-            frag_result = vec4(circle_color, 1.0f);
-        else if ((-0.010f < frag_pos.y && frag_pos.y < 0.010f) ||
-                 (-0.010f < frag_pos.x && frag_pos.x < 0.010f))
-            frag_result = vec4(circle_color * 0.6f, 0.3f);
-        else if (slope != -1.0f)
-        {
-            // Number 1 and Number 6
-            if (1.707f < slope && slope < 1.757f)
-                frag_result = vec4(circle_color, 1.0f);
-            // AA like thing
-            else if (1.690f < slope && slope < 1.772f)
-                frag_result = vec4(circle_color * 0.6f, 0.3f);  
-
-            // Number 2 and Number 7
-            else if (0.562f < slope && slope < 0.578f)
-                frag_result = vec4(circle_color, 1.0f);
-            // AA like thing
-            else if (0.557f < slope && slope < 0.583f)
-                frag_result = vec4(circle_color * 0.6f, 0.3f);
-            
-            // Number 5 and Number 11
-            else if (-1.757f < slope && slope < -1.707f)
-                frag_result = vec4(circle_color, 1.0f);
-            // AA like thing
-            else if (-1.772f < slope && slope < -1.690f)
-                frag_result = vec4(circle_color * 0.6f, 0.3f);
-
-            // Number 4 and Number 10
-            else if (-0.578f < slope && slope < -0.562f)
-                frag_result = vec4(circle_color, 1.0f);
-            // AA like thing
-            else if (-0.583f < slope && slope < -0.557f)
-                frag_result = vec4(circle_color * 0.6f, 0.3f);
-            else
-                discard;
-        }
-        else
-            discard;
-    }
     else
         discard;
 }
\ No newline at end of file
@@ -2,12 +2,45 @@
 
 layout (location = 0) in vec3 vert_pos;
 
-uniform mat4 model;
+// Shared by every clock program and filled from ClockState in
+// ClockRenderer.hpp, so the two have to be changed together
+layout (std140) uniform ClockState
+{
+    mat4 model;
+    vec3 circle_color;
+    float rim_thickness;
+    vec3 hand_color[3];
+    vec4 hand_length;
+    float radius;
+    float line_length;
+    int hour_ticks;
+    int minute_ticks;
+
+    // Set when there is no multisampling: shaders then output premultiplied
+    // color scaled by how much of the pixel they cover
+    int analytic_aa;
+
+    // The only part updated every frame: the local time of day in whole
+    // seconds and the fraction of the current second, kept apart so float
+    // precision does not limit how smoothly the hands sweep
+    vec2 time_of_day;
+};
+
+#ifdef INSTANCED
+// Per clock on a wall (WallInstance in ClockRenderer.hpp): the center and
+// scale of the clock in wall units
+layout (location = 1) in vec3 clock_instance;
+#endif
 
 out vec3 frag_pos;
 
 void main()
 {
+#ifdef INSTANCED
+    vec2 position = (vert_pos.xy * clock_instance.z) + clock_instance.xy;
+    gl_Position = model * vec4(position, 0.0f, 1.0f);
+#else
     gl_Position = model * vec4(vert_pos, 1.0f);
+#endif
     frag_pos = vert_pos;
 }
\ No newline at end of file
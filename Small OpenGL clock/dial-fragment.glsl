@@ -0,0 +1,12 @@
+#version 330 core
+
+// The dial was rendered at exactly the size of the target, so every fragment
+// fetches its own texel and no filtering is needed
+uniform sampler2D dial_texture;
+
+out vec4 frag_result;
+
+void main()
+{
+    frag_result = texelFetch(dial_texture, ivec2(gl_FragCoord.xy), 0);
+}
\ No newline at end of file
@@ -0,0 +1,8 @@
+#version 330 core
+
+layout (location = 0) in vec3 vert_pos;
+
+void main()
+{
+    gl_Position = vec4(vert_pos, 1.0f);
+}
\ No newline at end of file
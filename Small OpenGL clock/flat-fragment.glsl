@@ -0,0 +1,10 @@
+#version 330 core
+
+// Writes every fragment it gets, for counting how many the dial geometry
+// covers
+out vec4 frag_result;
+
+void main()
+{
+    frag_result = vec4(1.0f);
+}
\ No newline at end of file
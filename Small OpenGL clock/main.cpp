@@ -1,59 +1,89 @@
-#include "ShaderClass.hpp"
+#include "AssetPack.hpp"
+#include "Benchmark.hpp"
+#include "ClockRenderer.hpp"
+#include "ClockTicker.hpp"
+#include "FrameScheduler.hpp"
+#include "Framebuffer.hpp"
+#include "HeadlessContext.hpp"
+#include "Options.hpp"
+#include "PixelStreamer.hpp"
+#include "RedrawTracker.hpp"
+#include "RenderStats.hpp"
+#include "ShaderWatcher.hpp"
+#include "StartupTimeline.hpp"
+#include "Theme.hpp"
 
 #include <GLFW/glfw3.h>
 
 #include <array>
 #include <chrono>
+#include <cmath>
+#include <cstdint>
 #include <ctime>
 #include <iostream>
+#include <memory>
 #include <string_view>
-#include <thread>
+#include <vector>
 
 constexpr std::size_t window_width{ 400 };
 constexpr std::size_t window_height{ 400 };
 
+std::int32_t run_clock(GLFWwindow* window, Options& options,
+    AssetLoader& asset_loader, StartupTimeline& startup);
+std::int32_t run_headless(const Options& options, AssetLoader& asset_loader,
+    StartupTimeline& startup);
+std::int64_t utc_seconds_today(double day_seconds);
 void process_input(GLFWwindow* window);
-constexpr glm::vec3 hex2vec3(std::string_view hex);
-
-std::array<GLfloat, 12> quad_vertices{
-     1.0f,  1.0f, 0.0f,
-     1.0f, -1.0f, 0.0f,
-    -1.0f, -1.0f, 0.0f,
-    -1.0f,  1.0f, 0.0f
-};
-
-std::array<GLuint, 6> quad_indices{
-    0, 1, 2,
-    3, 0, 2
-};
-
-std::array<GLfloat, 27> hand_vertices{
-    // seconds hand
-    -0.04f, -0.04f, 0.0f,
-     0.04f, -0.04f, 0.0f,
-     0.0f,   0.8f,  0.0f,
-
-     // minutes hand
-     -0.04f, -0.04f, 0.0f,
-      0.04f, -0.04f, 0.0f,
-      0.0f,   0.6f,  0.0f,
-
-      // hours hand
-      -0.04f, -0.04f, 0.0f,
-       0.04f, -0.04f, 0.0f,
-       0.0f,   0.4f,  0.0f
-};
-
-std::int32_t main()
+void print_frame_stats(const FrameStats& stats);
+
+void framebuffer_size_callback(GLFWwindow* window, int width, int height);
+void window_focus_callback(GLFWwindow* window, int focused);
+void window_iconify_callback(GLFWwindow* window, int iconified);
+void window_refresh_callback(GLFWwindow* window);
+void key_callback(GLFWwindow* window, int key, int scancode, int action,
+    int mods);
+
+std::int32_t main(int argc, char* argv[])
 {
+    StartupTimeline startup{};
+
+    Options options{};
+    if (!parse_options(argc, argv, options))
+        return -1;
+
+    if (options.pack_assets)
+        return build_asset_pack(options.asset_pack_path) ? 0 : -1;
+
+    program_cache.set_enabled(options.shader_cache);
+    program_cache.set_directory(options.shader_cache_path);
+    startup.mark("Options");
+
+    // The pack is mapped and checked while GLFW, the window and the context
+    // are being set up, which do not need it
+    // Reloaded shaders are read from the loose files, so the pack, which
+    // would shadow them, is not used while watching
+    AssetLoader asset_loader{};
+    asset_loader.start(options.watch_shaders ? std::string{} :
+        options.asset_pack_path);
+
+    if (!options.benchmark.empty())
+    {
+        asset_loader.wait();
+        return run_benchmark(options.benchmark) ? 0 : -1;
+    }
+
+    if (options.headless)
+        return run_headless(options, asset_loader, startup);
+
     glfwInit();
+    startup.mark("GLFW init");
 
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
     glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
-    glfwWindowHint(GLFW_SAMPLES, 4);
+    glfwWindowHint(GLFW_SAMPLES, antialiasing_samples(options.antialiasing));
 
     ////////////////////////////////////////////////////////////////////////////
 
@@ -68,6 +98,7 @@ std::int32_t main()
     }
 
     glfwMakeContextCurrent(window);
+    startup.mark("Window");
 
     if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
     {
@@ -76,151 +107,345 @@ std::int32_t main()
         return -1;
     }
 
-    ////////////////////////////////////////////////////////////////////////////
+    enable_parallel_shader_compile((GLADloadproc)glfwGetProcAddress);
+    startup.mark("GL loader");
 
-    ShaderProgram circle_program{ "circle-vertex.glsl",
-        "circle-fragment.glsl" };
-    ShaderProgram triangle_program{ "triangle-vertex.glsl",
-        "triangle-fragment.glsl" };
+    // Everything holding GL objects lives in run_clock, so it is gone before
+    // the context is destroyed
+    std::int32_t result{ run_clock(window, options, asset_loader, startup) };
 
-    ////////////////////////////////////////////////////////////////////////////
+    glfwTerminate();
+    return result;
+}
 
-    GLuint VAOs[2]{}, VBOs[2]{}, EBO{};
-    glGenVertexArrays(2, VAOs);
-    glGenBuffers(2, VBOs);
-    glGenBuffers(1, &EBO);
+std::int32_t run_clock(GLFWwindow* window, Options& options,
+    AssetLoader& asset_loader, StartupTimeline& startup)
+{
+    asset_loader.wait();
+    startup.mark("Asset wait");
+    startup.add("Asset pack", asset_loader.get_begin(),
+        asset_loader.get_end());
+
+    // The shaders are all issued before the first one is checked, so they
+    // compile alongside each other and the buffer setup
+    ClockRenderer renderer{ options.antialiasing, options.hour_ticks,
+        options.minute_ticks, options.wall };
+    renderer.set_dial_cache(options.dial_cache);
+    startup.mark("Renderer");
+    bool first_frame{ true };
 
     ////////////////////////////////////////////////////////////////////////////
 
-    glBindVertexArray(VAOs[0]);
-    glBindBuffer(GL_ARRAY_BUFFER, VBOs[0]);
-    glBufferData(GL_ARRAY_BUFFER, quad_vertices.size() * sizeof(GLfloat),
-        quad_vertices.data(), GL_STATIC_DRAW);
+    RedrawTracker redraw{};
+    redraw.set_theme(options.theme);
 
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, (3 * sizeof(GLfloat)),
-        (void*)0);
+    int framebuffer_width{}, framebuffer_height{};
+    glfwGetFramebufferSize(window, &framebuffer_width, &framebuffer_height);
+    redraw.set_framebuffer_size(framebuffer_width, framebuffer_height);
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, quad_indices.size() * sizeof(GLuint),
-        quad_indices.data(), GL_STATIC_DRAW);
+    glfwSetWindowUserPointer(window, &redraw);
+    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    glfwSetWindowFocusCallback(window, window_focus_callback);
+    glfwSetWindowIconifyCallback(window, window_iconify_callback);
+    glfwSetWindowRefreshCallback(window, window_refresh_callback);
+    glfwSetKeyCallback(window, key_callback);
 
     ////////////////////////////////////////////////////////////////////////////
 
-    glBindVertexArray(VAOs[1]);
-    glBindBuffer(GL_ARRAY_BUFFER, VBOs[1]);
-    glBufferData(GL_ARRAY_BUFFER, hand_vertices.size() * sizeof(GLfloat),
-        hand_vertices.data(), GL_STATIC_DRAW);
+    // Headless and some Wayland setups have no primary monitor to ask
+    const GLFWvidmode* mode{ glfwGetVideoMode(glfwGetPrimaryMonitor()) };
+    double refresh_rate{ (mode && mode->refreshRate > 0) ?
+        mode->refreshRate : 60.0 };
 
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, (3 * sizeof(GLfloat)),
-        (void*)0);
+    if (options.target_rate == 0.0)
+        options.target_rate = refresh_rate;
 
-    glBindVertexArray(0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    ClockTicker ticker{ options.target_rate };
+    ticker.start(glfwPostEmptyEvent, options.use_timerfd);
 
     ////////////////////////////////////////////////////////////////////////////
 
-    glm::vec3 circle_color{ hex2vec3("fbf1c7") };
-    float radius{ 0.9f };
-    float line_length{ 0.75f };
+    // Index 0 holds the ticking mode and index 1 the sweeping mode
+    std::array<GpuTimer, 2> gpu_timers{};
+    std::array<RenderStats, 2> render_stats{};
 
-    glm::vec3 triangle_colors[3]{ hex2vec3("cc241d"),
-                                  hex2vec3("8ec07c"),
-                                  hex2vec3("fabd2f") };
+    bool sweeping{ false };
+    double mode_cpu_begin{ process_cpu_seconds() };
+    double mode_wall_begin{ glfwGetTime() };
 
-    glm::mat4 model{ 1.0f };
-    auto clear_color{ hex2vec3("1d2021") };
+    // Charges the CPU and wall time since the last switch to the mode that
+    // was active, so adaptive runs still report each mode on its own
+    auto account_mode_time = [&]() {
+        double cpu_now{ process_cpu_seconds() };
+        double wall_now{ glfwGetTime() };
+
+        render_stats[sweeping].cpu_seconds += cpu_now - mode_cpu_begin;
+        render_stats[sweeping].wall_seconds += wall_now - mode_wall_begin;
+
+        mode_cpu_begin = cpu_now;
+        mode_wall_begin = wall_now;
+    };
+
+    glfwSwapInterval(0);
+
+    ////////////////////////////////////////////////////////////////////////////
+
+    // A stream needs a frame for every tick (or every vsync while sweeping),
+    // not only when the picture changes. Its header declares one rate, so
+    // an adaptive clock keeps sweeping while it streams rather than drop to
+    // the tick rate whenever the window is hidden.
+    std::unique_ptr<PixelStreamer> streamer{};
+    std::uint64_t streamed_epoch{ 0 };
+
+    if (options.stream_format != StreamFormat::none)
+        streamer = std::make_unique<PixelStreamer>(framebuffer_width,
+            framebuffer_height, options.stream_format, options.stream_fd,
+            options.sweep_mode == SweepMode::off ? options.target_rate :
+                refresh_rate);
 
     ////////////////////////////////////////////////////////////////////////////
 
-    glEnable(GL_MULTISAMPLE);
+    ShaderWatcher shader_watcher{};
+    if (options.watch_shaders &&
+        !shader_watcher.start(".", glfwPostEmptyEvent))
+        std::cerr << "Error: Unable to watch the shaders for changes\n";
+
+    // Without the extension the links are waited for in the render loop
+    if (options.watch_shaders && !parallel_shader_compile)
+        std::cerr << "Warning: The driver has no parallel shader compile, so "
+                     "reloading the shaders will stall a few frames\n";
+
+    ////////////////////////////////////////////////////////////////////////////
 
     while (!glfwWindowShouldClose(window))
     {
-        double time_begin{ glfwGetTime() };
+        // Sleep until either a window event arrives or the ticker publishes
+        // new angles, which it follows up with an empty event. A sweeping
+        // clock never sleeps here and is paced by vsync in the buffer swap.
+        // While reloaded shaders compile, it wakes up now and then to check
+        // on them.
+        if (redraw.needs_redraw())
+            glfwPollEvents();
+        else if (renderer.is_reloading_shaders())
+            glfwWaitEventsTimeout(0.005);
+        else
+            glfwWaitEvents();
 
         process_input(window);
 
-        glClearColor(clear_color.x, clear_color.y, clear_color.z, 0.0f);
-        glClear(GL_COLOR_BUFFER_BIT);
+        if (shader_watcher.take_changes())
+            renderer.reload_shaders();
+        if (renderer.update_reloaded_shaders())
+            redraw.mark_dirty();
+
+        // GLFW reports iconified and hidden windows but not ones covered
+        // by others, so those keep sweeping
+        bool visible{ !redraw.is_iconified() &&
+            glfwGetWindowAttrib(window, GLFW_VISIBLE) == GLFW_TRUE };
+        bool sweep{ options.sweep_mode == SweepMode::on ||
+            (options.sweep_mode == SweepMode::adaptive &&
+                (visible || streamer)) };
+        if (sweep != sweeping)
+        {
+            account_mode_time();
+            sweeping = sweep;
+            glfwSwapInterval(sweeping ? 1 : 0);
+        }
 
-        ////////////////////////////////////////////////////////////////////////
+        HandAngles angles{ ticker.load() };
+        redraw.set_displayed_second(
+            static_cast<std::time_t>(angles.utc_seconds));
+
+        if (sweeping)
+        {
+            angles = extrapolate_hand_angles(angles);
+            redraw.mark_dirty();
+        }
+
+        bool stream_frame{ streamer &&
+            (sweeping || angles.epoch != streamed_epoch) };
+        if (stream_frame)
+        {
+            streamed_epoch = angles.epoch;
+            redraw.mark_dirty();
+        }
+
+        if (!redraw.needs_redraw())
+            continue;
+
+        redraw.clear();
 
-        circle_program.activate_program();
-        circle_program.set_mat4("model", model);
-        circle_program.set_vec3("circle_color", circle_color);
-        circle_program.set_float("radius", radius);
-        circle_program.set_float("line_length", line_length);
+        gpu_timers[sweeping].begin();
 
-        glBindVertexArray(VAOs[0]);
-        glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+        renderer.draw(themes[redraw.get_theme()], angles,
+            redraw.get_framebuffer_width(), redraw.get_framebuffer_height());
+
+        gpu_timers[sweeping].end();
+
+        if (stream_frame)
+            streamer->capture(0);
 
         ////////////////////////////////////////////////////////////////////////
 
-        time_t now_time = std::chrono::system_clock::to_time_t(
-            std::chrono::system_clock::now());
-        tm local_tm = *std::localtime(&now_time);
+        glfwSwapBuffers(window);
+
+        if (first_frame)
+        {
+            startup.mark("First frame");
+            first_frame = false;
+        }
 
-        float sec_degrees = ((float)local_tm.tm_sec / 60) * 360;
-        float min_degrees = ((float)local_tm.tm_min / 60) * 360 +
-            ((sec_degrees / 360) * 5);
-        float hour_degrees = ((float)local_tm.tm_hour / 12) * 360 +
-            ((min_degrees / 360) * 29);
+        gpu_timers[sweeping].collect();
+        render_stats[sweeping].frames++;
 
         ////////////////////////////////////////////////////////////////////////
+    }
+
+    ticker.stop();
+    account_mode_time();
+
+    if (streamer)
+        streamer->finish();
+
+    if (options.print_stats)
+    {
+        print_frame_stats(ticker.get_stats());
+        startup.print();
+        program_cache.print_stats();
+
+        constexpr std::string_view mode_names[2]{ "tick", "sweep" };
+        for (std::size_t mode{ 0 }; mode < 2; mode++)
+        {
+            if (render_stats[mode].wall_seconds <= 0.0)
+                continue;
 
-        glBindVertexArray(VAOs[1]);
+            gpu_timers[mode].collect(true);
+            render_stats[mode].print(mode_names[mode], gpu_timers[mode]);
+        }
+    }
 
-        triangle_program.activate_program();
+    return 0;
+}
 
-        auto draw_hand =
-            [&triangle_program, &triangle_colors, &model](int index,
-                float rotate, int begin, int end) {
-                    triangle_program.set_vec3("triangle_color",
-                        triangle_colors[index]);
+// Renders without a window into an offscreen framebuffer, either a single
+// frame written to disk or a stream of frames. With a fixed time of day the
+// stream is rendered as fast as possible, otherwise in real time.
+std::int32_t run_headless(const Options& options, AssetLoader& asset_loader,
+    StartupTimeline& startup)
+{
+    HeadlessContext context{};
+    if (!context.is_current())
+        return -1;
 
-                    model = glm::rotate(model, rotate,
-                        glm::vec3{ 0.0f, 0.0f, -1.0f });
+    enable_parallel_shader_compile(context.get_loader());
+    startup.mark("GL context");
 
-                    triangle_program.set_mat4("model", model);
-                    model = glm::mat4{ 1.0f };
+    asset_loader.wait();
+    startup.mark("Asset wait");
+    startup.add("Asset pack", asset_loader.get_begin(),
+        asset_loader.get_end());
 
-                    glDrawArrays(GL_TRIANGLES, begin, end);
-        };
+    ClockRenderer renderer{ options.antialiasing, options.hour_ticks,
+        options.minute_ticks, options.wall };
+    renderer.set_dial_cache(options.dial_cache);
+    Framebuffer target{ options.width, options.height,
+        renderer.get_samples() };
+    startup.mark("Renderer");
 
-        draw_hand(0, glm::radians(sec_degrees), 0, 3);
-        draw_hand(1, glm::radians(min_degrees), 3, 6);
-        draw_hand(2, glm::radians(hour_degrees), 6, 9);
+    if (options.stream_format == StreamFormat::none)
+    {
+        HandAngles angles{ options.time_of_day < 0.0 ?
+            compute_hand_angles(TimeService{}.snapshot()) :
+            compute_hand_angles(options.time_of_day) };
 
-        ////////////////////////////////////////////////////////////////////////
+        // A wall shows a fixed time as that UTC time of day today
+        if (options.time_of_day >= 0.0)
+            angles.utc_seconds = utc_seconds_today(options.time_of_day);
 
-        glfwSwapBuffers(window);
+        target.bind();
+        renderer.draw(themes[options.theme], angles, options.width,
+            options.height);
+
+        std::vector<std::uint8_t> pixels{};
+        if (renderer.get_samples() > 0)
+        {
+            Framebuffer resolved{ options.width, options.height };
+            target.resolve_into(resolved);
+            resolved.read_pixels(pixels);
+        }
+        else
+            target.read_pixels(pixels);
+        startup.mark("First frame");
 
-        double time_end{ glfwGetTime() };
+        if (options.print_stats)
+        {
+            startup.print();
+            program_cache.print_stats();
+        }
+
+        return write_ppm(options.output_path, options.width, options.height,
+            pixels) ? 0 : -1;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+
+    double rate{ options.target_rate > 0.0 ? options.target_rate : 60.0 };
+    bool sweep{ options.sweep_mode != SweepMode::off };
 
-        // Draw 5 times per second
-        if ((time_begin - time_end * 1000) < 200.0f)
+    PixelStreamer streamer{ options.width, options.height,
+        options.stream_format, options.stream_fd, rate };
+    FrameScheduler scheduler{ rate };
+    TimeService time_service{};
+
+    for (long long frame{ 0 };
+        options.frames == 0 || frame < options.frames; frame++)
+    {
+        double day_seconds{};
+        std::int64_t utc_seconds{};
+
+        if (options.time_of_day >= 0.0)
         {
-            std::this_thread::sleep_for(
-                std::chrono::duration<double, std::milli>(
-                    200.0f - ((time_begin - time_end) * 1000)
-                    )
-            );
+            day_seconds = std::fmod(options.time_of_day +
+                (static_cast<double>(frame) / rate), 86400.0);
+            utc_seconds = utc_seconds_today(day_seconds);
+        }
+        else
+        {
+            scheduler.wait_for_deadline();
+            scheduler.begin_frame();
+
+            LocalTime local_time{ time_service.snapshot() };
+            day_seconds = (local_time.hour * 3600.0) +
+                (local_time.minute * 60.0) + local_time.second +
+                local_time.subsecond;
+            utc_seconds = local_time.utc_seconds;
         }
 
-        glfwPollEvents();
+        if (!sweep)
+            day_seconds = std::floor(day_seconds);
 
-        ////////////////////////////////////////////////////////////////////////
+        HandAngles angles{ compute_hand_angles(day_seconds) };
+        angles.utc_seconds = utc_seconds;
+
+        target.bind();
+        renderer.draw(themes[options.theme], angles, options.width,
+            options.height);
+        streamer.capture(target.get_framebuffer_id());
+
+        if (streamer.has_failed())
+            break;
     }
 
-    glDeleteVertexArrays(2, VAOs);
-    glDeleteBuffers(2, VBOs);
-    glDeleteBuffers(1, &EBO);
+    streamer.finish();
+    return streamer.has_failed() ? -1 : 0;
+}
 
-    glfwTerminate();
-    return 0;
+// Seconds since the epoch at a UTC time of day on the current UTC date, so
+// a fixed time on a wall of zones falls in today's daylight saving time
+std::int64_t utc_seconds_today(double day_seconds)
+{
+    std::int64_t now{ static_cast<std::int64_t>(std::time(nullptr)) };
+    return (now - (now % 86400)) + static_cast<std::int64_t>(day_seconds);
 }
 
 void process_input(GLFWwindow* window)
@@ -231,36 +456,53 @@ void process_input(GLFWwindow* window)
     }
 }
 
-constexpr glm::vec3 hex2vec3(std::string_view hex)
+void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 {
-    auto to_int = [](char ch) {
-        switch (ch) {
-        case '0': return 0;
-        case '1': return 1;
-        case '2': return 2;
-        case '3': return 3;
-        case '4': return 4;
-        case '5': return 5;
-        case '6': return 6;
-        case '7': return 7;
-        case '8': return 8;
-        case '9': return 9;
-        case 'a': return 10;
-        case 'b': return 11;
-        case 'c': return 12;
-        case 'd': return 13;
-        case 'e': return 14;
-        case 'f': return 15;
-        default: return -1;
-        }
-    };
+    auto* redraw{ static_cast<RedrawTracker*>(
+        glfwGetWindowUserPointer(window)) };
+    redraw->set_framebuffer_size(width, height);
+}
 
-    float red =
-        static_cast<float>((to_int(hex[0]) * 16) + to_int(hex[1])) / 255;
-    float green =
-        static_cast<float>((to_int(hex[2]) * 16) + to_int(hex[3])) / 255;
-    float blue =
-        static_cast<float>((to_int(hex[4]) * 16) + to_int(hex[5])) / 255;
+void window_focus_callback(GLFWwindow* window, int focused)
+{
+    auto* redraw{ static_cast<RedrawTracker*>(
+        glfwGetWindowUserPointer(window)) };
+    redraw->set_focused(focused == GLFW_TRUE);
+}
 
-    return { red, green, blue };
-}
\ No newline at end of file
+void window_iconify_callback(GLFWwindow* window, int iconified)
+{
+    auto* redraw{ static_cast<RedrawTracker*>(
+        glfwGetWindowUserPointer(window)) };
+    redraw->set_iconified(iconified == GLFW_TRUE);
+}
+
+// The window system lost the contents of the window, e.g. after it was
+// uncovered, so it has to be drawn again even though nothing changed
+void window_refresh_callback(GLFWwindow* window)
+{
+    auto* redraw{ static_cast<RedrawTracker*>(
+        glfwGetWindowUserPointer(window)) };
+    redraw->mark_dirty();
+}
+
+void key_callback(GLFWwindow* window, int key, int, int action, int)
+{
+    auto* redraw{ static_cast<RedrawTracker*>(
+        glfwGetWindowUserPointer(window)) };
+
+    if (key == GLFW_KEY_T && action == GLFW_PRESS)
+        redraw->set_theme((redraw->get_theme() + 1) % themes.size());
+}
+
+void print_frame_stats(const FrameStats& stats)
+{
+    auto to_ms = [](std::chrono::nanoseconds value) {
+        return std::chrono::duration<double, std::milli>(value).count();
+    };
+
+    std::cerr << "Frames:           " << stats.frames << '\n'
+              << "Missed deadlines: " << stats.missed_deadlines << '\n'
+              << "Mean lateness:    " << to_ms(stats.mean_lateness()) << " ms\n"
+              << "Max lateness:     " << to_ms(stats.max_lateness) << " ms\n";
+}
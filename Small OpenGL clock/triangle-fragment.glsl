@@ -1,10 +1,53 @@
 #version 330 core
 
-uniform vec3 triangle_color;
+flat in vec3 triangle_color;
+noperspective in vec3 barycentric;
+
+// Shared by every clock program and filled from ClockState in
+// ClockRenderer.hpp, so the two have to be changed together
+layout (std140) uniform ClockState
+{
+    mat4 model;
+    vec3 circle_color;
+    float rim_thickness;
+    vec3 hand_color[3];
+    vec4 hand_length;
+    float radius;
+    float line_length;
+    int hour_ticks;
+    int minute_ticks;
+
+    // Set when there is no multisampling: shaders then output premultiplied
+    // color scaled by how much of the pixel they cover
+    int analytic_aa;
+
+    // The only part updated every frame: the local time of day in whole
+    // seconds and the fraction of the current second, kept apart so float
+    // precision does not limit how smoothly the hands sweep
+    vec2 time_of_day;
+};
+
+// Settings the program can be specialized for with #defines injected after
+// the #version line (see ShaderVariants in ShaderClass.hpp). Left undefined,
+// they are read from ClockState at runtime.
+#ifndef ANALYTIC_AA
+#  define ANALYTIC_AA (analytic_aa != 0)
+#endif
 
 out vec4 frag_result;
 
 void main()
 {
-    frag_result = vec4(triangle_color, 1.0f);
+    if (ANALYTIC_AA)
+    {
+        // Distance in pixels to the nearest edge; a fragment centered on the
+        // edge covers half of its pixel
+        vec3 edge = barycentric / fwidth(barycentric);
+        float coverage = clamp(min(min(edge.x, edge.y), edge.z) + 0.5f,
+            0.0f, 1.0f);
+
+        frag_result = vec4(triangle_color * coverage, coverage);
+    }
+    else
+        frag_result = vec4(triangle_color, 1.0f);
 }
\ No newline at end of file
@@ -1,10 +1,83 @@
 #version 330 core
 
+// x and y of the hand at its base; z is 1 for the tip, which is moved out to
+// the length of the hand drawn by this instance
 layout (location = 0) in vec3 vert_pos;
 
-uniform mat4 model;
+// Shared by every clock program and filled from ClockState in
+// ClockRenderer.hpp, so the two have to be changed together
+layout (std140) uniform ClockState
+{
+    mat4 model;
+    vec3 circle_color;
+    float rim_thickness;
+    vec3 hand_color[3];
+    vec4 hand_length;
+    float radius;
+    float line_length;
+    int hour_ticks;
+    int minute_ticks;
+
+    // Set when there is no multisampling: shaders then output premultiplied
+    // color scaled by how much of the pixel they cover
+    int analytic_aa;
+
+    // The only part updated every frame: the local time of day in whole
+    // seconds and the fraction of the current second, kept apart so float
+    // precision does not limit how smoothly the hands sweep
+    vec2 time_of_day;
+};
+
+#ifdef INSTANCED
+// Per clock on a wall (WallInstance in ClockRenderer.hpp): the center and
+// scale of the clock in wall units, and the angles of its hands as fractions
+// of a full turn, worked out on the CPU for all clocks at once. Every clock
+// draws three instances, one per hand.
+layout (location = 1) in vec3 clock_instance;
+layout (location = 2) in float second_turns;
+layout (location = 3) in float minute_turns;
+layout (location = 4) in float hour_turns;
+#  define HAND (gl_InstanceID % 3)
+#else
+#  define HAND gl_InstanceID
+#endif
+
+flat out vec3 triangle_color;
+
+// Barycentric coordinates, for finding the distance to the nearest edge
+noperspective out vec3 barycentric;
+
+// Seconds it takes each hand to go around once
+const float hand_period[3] = float[3](60.0f, 3600.0f, 43200.0f);
 
 void main()
 {
-    gl_Position = model * vec4(vert_pos, 1.0f);
+    // Clockwise from 12 o'clock
+#ifdef INSTANCED
+    float angle = radians(
+        vec3(second_turns, minute_turns, hour_turns)[HAND] * 360.0f);
+#else
+    float period = hand_period[HAND];
+    float seconds = mod(time_of_day.x, period) + time_of_day.y;
+    float angle = radians((seconds * 360.0f) / period);
+#endif
+
+    vec2 position = vec2(vert_pos.x,
+        mix(vert_pos.y, hand_length[HAND], vert_pos.z));
+
+    float s = sin(angle);
+    float c = cos(angle);
+    vec2 turned = vec2((position.x * c) + (position.y * s),
+        (position.y * c) - (position.x * s));
+
+#ifdef INSTANCED
+    turned = (turned * clock_instance.z) + clock_instance.xy;
+    gl_Position = model * vec4(turned, 0.0f, 1.0f);
+#else
+    gl_Position = vec4(turned, 0.0f, 1.0f);
+#endif
+
+    triangle_color = hand_color[HAND];
+    barycentric = vec3(0.0f);
+    barycentric[gl_VertexID] = 1.0f;
 }
\ No newline at end of file